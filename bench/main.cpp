@@ -0,0 +1,460 @@
+#include "pch.h"
+#include "mock_heap.h"
+#include "refs/cycles.h"
+#include "refs/diff.h"
+#include "refs/dominators.h"
+#include "refs/graph.h"
+#include "refs/groups.h"
+#include "refs/neighbourhood.h"
+#include "refs/parallel_for.h"
+#include "refs/path_names.h"
+#include "refs/paths.h"
+#include "refs/reachability.h"
+#include "refs/roots.h"
+#include "refs/snapshot_file.h"
+
+using namespace live_object_explorer;
+using namespace live_object_explorer::refs::internal;
+
+namespace {
+
+using steady_clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    bench::MockHeapConfig heap;
+    std::vector<size_t> thread_counts;
+    size_t runs = 3;
+};
+
+/**
+ * @brief How long each of the analysis passes run over a finished graph took.
+ */
+struct AnalysisResult {
+    steady_clock::duration roots;
+    steady_clock::duration unreachable;
+    steady_clock::duration dominators;
+    steady_clock::duration cycles;
+    steady_clock::duration paths;
+    steady_clock::duration neighbourhood;
+    steady_clock::duration grouping;
+    steady_clock::duration diff;
+
+    [[nodiscard]] steady_clock::duration total(void) const {
+        return this->roots + this->unreachable + this->dominators + this->cycles + this->paths
+               + this->neighbourhood + this->grouping + this->diff;
+    }
+};
+
+struct RunResult {
+    steady_clock::duration scanning;
+    steady_clock::duration naming;
+    steady_clock::duration building;
+    steady_clock::duration encoding;
+    steady_clock::duration decoding;
+
+    size_t refs_found;
+    size_t refs_kept;
+    size_t graph_memory;
+    size_t file_size;
+    // How far memory usage rose above where it started, in bytes. Zero if we can't measure it.
+    size_t peak_memory;
+
+    AnalysisResult analysis;
+
+    [[nodiscard]] steady_clock::duration total(void) const {
+        return this->scanning + this->naming + this->building;
+    }
+};
+
+/**
+ * @brief A sink which buffers up all non-null refs into a vector, same as `EdgeBuffer`.
+ */
+struct EdgeBuffer {
+    std::vector<std::pair<uintptr_t, uintptr_t>> edges;
+
+    void operator()(const bench::MockObject* from_obj, const bench::MockObject* to_obj) {
+        if (to_obj == nullptr) {
+            return;
+        }
+        this->edges.emplace_back(reinterpret_cast<uintptr_t>(from_obj),
+                                 reinterpret_cast<uintptr_t>(to_obj));
+    }
+};
+
+/**
+ * @brief Reads a memory field out of `/proc/self/status`.
+ *
+ * @param field The field to read, including the trailing colon.
+ * @return The field's value in bytes, or zero if it couldn't be read.
+ */
+size_t read_status_memory(std::string_view field) {
+    const size_t bytes_per_kb = 1024;
+
+    std::ifstream status{"/proc/self/status"};
+    std::string line{};
+    while (std::getline(status, line)) {
+        if (line.starts_with(field)) {
+            return std::stoull(line.substr(field.size())) * bytes_per_kb;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Resets the peak memory usage reported by `/proc/self/status`.
+ *
+ * @return True if successfully reset.
+ */
+bool reset_peak_memory(void) {
+    std::ofstream clear_refs{"/proc/self/clear_refs"};
+    clear_refs << "5";
+    clear_refs.close();
+    return !clear_refs.fail();
+}
+
+/**
+ * @brief Runs each of the analysis passes the search window offers over a graph.
+ *
+ * @param graph The graph to analyse.
+ * @param other A second copy of the graph, to diff against.
+ * @param thread_count How many threads to use, for the passes which support it.
+ * @return How long each pass took.
+ */
+AnalysisResult run_analysis(const Graph& graph, const Graph& other, size_t thread_count) {
+    // How many targets to find the path to, and how many refs out to search around an object
+    const size_t num_path_targets = 100;
+    const size_t neighbourhood_depth = 3;
+    const size_t max_neighbourhood = 100'000;
+
+    AnalysisResult result{};
+
+    auto phase_start = steady_clock::now();
+    auto roots = find_roots(graph, RootKind::ALWAYS_ALIVE);
+    auto phase_end = steady_clock::now();
+    result.roots = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto unreachable = find_unreachable(graph, roots, thread_count, std::stop_token{});
+    phase_end = steady_clock::now();
+    result.unreachable = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto dominators = build_dominator_tree(graph, roots, std::stop_token{});
+    phase_end = steady_clock::now();
+    result.dominators = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto cycles = find_cycles(graph, false, std::stop_token{});
+    phase_end = steady_clock::now();
+    result.cycles = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto num_objects = static_cast<object_id>(graph.num_objects());
+    size_t path_steps = 0;
+    for (size_t i = 0; i < num_path_targets; i++) {
+        auto target = static_cast<object_id>((num_objects * (i + 1)) / (num_path_targets + 1));
+        path_steps += find_shortest_path(graph, roots, target).size();
+    }
+    phase_end = steady_clock::now();
+    result.paths = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto neighbourhood =
+        find_neighbourhood(graph, num_objects / 2, RefDirection::FROM, neighbourhood_depth, {},
+                           max_neighbourhood, std::stop_token{});
+    phase_end = steady_clock::now();
+    result.neighbourhood = phase_end - phase_start;
+    phase_start = phase_end;
+
+    std::vector<object_id> all_ids(num_objects);
+    std::iota(all_ids.begin(), all_ids.end(), object_id{0});
+    auto groups = group_objects(graph, all_ids, GroupKind::CLASS);
+    phase_end = steady_clock::now();
+    result.grouping = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto diff = diff_graphs(graph, other, std::stop_token{});
+    result.diff = steady_clock::now() - phase_start;
+
+    // Every object's a copy of one in the other graph, so there should never be any differences
+    if (!diff.added.empty() || !diff.removed.empty() || !diff.changed.empty()) {
+        std::cerr << "Diffing a graph against itself found differences\n";
+    }
+    // Make sure none of the passes can be optimized away
+    if (dominators.idoms.size() != num_objects || unreachable.size() > num_objects
+        || cycles.members.size() > num_objects || neighbourhood.ids.size() > max_neighbourhood
+        || groups.empty() || path_steps > num_objects * num_path_targets) {
+        std::cerr << "Analysis produced invalid results\n";
+    }
+
+    return result;
+}
+
+/**
+ * @brief Takes a single snapshot of the mock heap.
+ * @note Mirrors `run_snapshot`, minus suspending threads, progress, and cancellation.
+ *
+ * @param heap The heap to snapshot.
+ * @param thread_count How many threads to use.
+ * @return The results.
+ */
+RunResult run_snapshot(const bench::MockHeap& heap, size_t thread_count) {
+    const size_t root_interval = 16;
+
+    RunResult result{};
+
+    auto can_measure_memory = reset_peak_memory();
+    auto start_memory = read_status_memory("VmRSS:");
+
+    std::vector<GraphShard> shards(thread_count);
+    std::vector<std::vector<ObjectRecord>> thread_records(thread_count);
+
+    auto phase_start = steady_clock::now();
+    parallel_for(heap.size(), thread_count, [&](size_t thread_idx, ChunkCursor& cursor) {
+        auto& shard = shards[thread_idx];
+        auto& records = thread_records[thread_idx];
+        EdgeBuffer add_ref{};
+
+        size_t start_idx = 0;
+        size_t end_idx = 0;
+        while (cursor.next(start_idx, end_idx)) {
+            for (auto i = start_idx; i < end_idx; i++) {
+                auto obj = heap.obj_at(i);
+                records.push_back({
+                    .obj = reinterpret_cast<uintptr_t>(obj),
+                    .outer = reinterpret_cast<uintptr_t>(obj->outer),
+                    .cls = reinterpret_cast<uintptr_t>(obj->cls),
+                    .name = obj->name,
+                    .gobjects_idx = i,
+                    .refs_hash = 0,
+                    // Root a spread of objects, so the analysis passes have some heap to walk
+                    .flags = i % root_interval == 0 ? OBJECT_FLAG_ROOT : uint8_t{0},
+                    .shallow_size = 0,
+                });
+                heap.search_for_refs(obj, add_ref);
+            }
+        }
+        shard.refs = std::move(add_ref.edges);
+    });
+    auto phase_end = steady_clock::now();
+    result.scanning = phase_end - phase_start;
+    phase_start = phase_end;
+
+    std::vector<ObjectRecord> records{};
+    for (auto& vec : thread_records) {
+        records.insert(records.end(), vec.begin(), vec.end());
+        vec = {};
+    }
+    std::ranges::sort(records, {}, &ObjectRecord::obj);
+
+    auto package_class = reinterpret_cast<uintptr_t>(heap.package_class());
+    parallel_for(records.size(), thread_count, [&](size_t thread_idx, ChunkCursor& cursor) {
+        PathNameBuilder builder{records, package_class};
+
+        size_t start_idx = 0;
+        size_t end_idx = 0;
+        while (cursor.next(start_idx, end_idx)) {
+            for (auto i = start_idx; i < end_idx; i++) {
+                builder.add_object(i, shards[thread_idx]);
+            }
+        }
+    });
+    phase_end = steady_clock::now();
+    result.naming = phase_end - phase_start;
+    phase_start = phase_end;
+
+    result.refs_found =
+        std::transform_reduce(shards.begin(), shards.end(), size_t{0}, std::plus{},
+                              [](auto& shard) { return shard.refs.size(); });
+    const Graph graph{std::move(shards), thread_count};
+    phase_end = steady_clock::now();
+    result.building = phase_end - phase_start;
+    phase_start = phase_end;
+
+    result.refs_kept = graph.num_refs();
+    result.graph_memory = graph.memory_usage();
+
+    auto file = encode_snapshot(graph);
+    phase_end = steady_clock::now();
+    result.encoding = phase_end - phase_start;
+    phase_start = phase_end;
+    result.file_size = file.size();
+
+    auto decoded = decode_snapshot({reinterpret_cast<const uint8_t*>(file.data()), file.size()});
+    result.decoding = steady_clock::now() - phase_start;
+    if (decoded == nullptr || decoded->num_refs() != graph.num_refs()) {
+        std::cerr << "Snapshot file failed to round trip\n";
+    }
+
+    if (can_measure_memory) {
+        auto peak_memory = read_status_memory("VmHWM:");
+        result.peak_memory = peak_memory > start_memory ? peak_memory - start_memory : 0;
+    }
+
+    // Not part of taking the snapshot, so don't count towards it's peak memory
+    if (decoded != nullptr) {
+        result.analysis = run_analysis(graph, *decoded, thread_count);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Prints the command line usage.
+ *
+ * @param program The program name.
+ */
+void print_usage(const char* program) {
+    const bench::MockHeapConfig defaults{};
+    std::printf(
+        "Usage: %s [options]\n"
+        "\n"
+        "Benchmarks taking refs snapshots of a randomly generated mock object heap.\n"
+        "\n"
+        "  --objects N         Instance objects to generate (default %zu)\n"
+        "  --packages N        Packages to spread them across (default %zu)\n"
+        "  --classes N         Classes to generate (default %zu)\n"
+        "  --depth N           Max class inheritance depth (default %zu)\n"
+        "  --object-props N    Average object properties added per class (default %zu)\n"
+        "  --array-props N     Average array properties added per class (default %zu)\n"
+        "  --array-size N      Average array length (default %zu)\n"
+        "  --null-chance F     Chance each reference is null (default %.2f)\n"
+        "  --nested-chance F   Chance each object is nested in another (default %.2f)\n"
+        "  --seed N            Random seed (default %llu)\n"
+        "  --threads A,B,...   Thread counts to try (default powers of two up to cpu count)\n"
+        "  --runs N            Runs per thread count, the fastest is reported (default 3)\n",
+        program, defaults.objects, defaults.packages, defaults.classes, defaults.max_class_depth,
+        defaults.object_props, defaults.array_props, defaults.array_size, defaults.null_chance,
+        defaults.nested_chance, static_cast<unsigned long long>(defaults.seed));
+}
+
+/**
+ * @brief Parses the command line args.
+ *
+ * @param argc The arg count.
+ * @param argv The args.
+ * @return The parsed config, or an empty optional if invalid.
+ */
+std::optional<BenchConfig> parse_args(int argc, char* argv[]) {
+    BenchConfig config{};
+
+    const std::unordered_map<std::string_view, size_t*> size_args{
+        {"--objects", &config.heap.objects},
+        {"--packages", &config.heap.packages},
+        {"--classes", &config.heap.classes},
+        {"--depth", &config.heap.max_class_depth},
+        {"--object-props", &config.heap.object_props},
+        {"--array-props", &config.heap.array_props},
+        {"--array-size", &config.heap.array_size},
+        {"--runs", &config.runs},
+    };
+    const std::unordered_map<std::string_view, double*> chance_args{
+        {"--null-chance", &config.heap.null_chance},
+        {"--nested-chance", &config.heap.nested_chance},
+    };
+
+    std::span<char*> args{argv, static_cast<size_t>(argc)};
+    try {
+        for (size_t i = 1; i < args.size(); i++) {
+            const std::string_view arg{args[i]};
+            if (i + 1 >= args.size()) {
+                return std::nullopt;
+            }
+            const std::string value{args[++i]};
+
+            if (auto iter = size_args.find(arg); iter != size_args.end()) {
+                *iter->second = std::stoull(value);
+            } else if (auto iter = chance_args.find(arg); iter != chance_args.end()) {
+                *iter->second = std::clamp(std::stod(value), 0.0, 1.0);
+            } else if (arg == "--seed") {
+                config.heap.seed = std::stoull(value);
+            } else if (arg == "--threads") {
+                for (auto part : std::views::split(value, ',')) {
+                    auto count = std::stoull(std::string{part.begin(), part.end()});
+                    if (count > 0) {
+                        config.thread_counts.push_back(count);
+                    }
+                }
+            } else {
+                return std::nullopt;
+            }
+        }
+    } catch (const std::logic_error&) {
+        return std::nullopt;
+    }
+
+    if (config.thread_counts.empty()) {
+        auto max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+        for (size_t count = 1; count < max_threads; count *= 2) {
+            config.thread_counts.push_back(count);
+        }
+        config.thread_counts.push_back(max_threads);
+    }
+    config.runs = std::max<size_t>(config.runs, 1);
+
+    return config;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto config = parse_args(argc, argv);
+    if (!config.has_value()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    using seconds = std::chrono::duration<double>;
+    const double bytes_per_mib = 1024.0 * 1024.0;
+
+    auto generate_start = steady_clock::now();
+    const bench::MockHeap heap{config->heap};
+    std::printf("Generated %zu objects in %.0f ms\n\n", heap.size(),
+                milliseconds{steady_clock::now() - generate_start}.count());
+
+    std::printf("%7s %9s %9s %9s %9s %12s %11s %11s %9s %9s %9s %9s %9s\n", "threads", "scan ms",
+                "name ms", "build ms", "total ms", "edges/s", "refs found", "refs kept",
+                "graph MiB", "file MiB", "enc ms", "dec ms", "peak MiB");
+
+    std::vector<std::pair<size_t, AnalysisResult>> analysis_results{};
+    for (auto thread_count : config->thread_counts) {
+        // Start the workers outside the timed runs, same as the real snapshot does
+        reserve_workers(thread_count);
+
+        std::optional<RunResult> best{};
+        for (size_t run = 0; run < config->runs; run++) {
+            auto result = run_snapshot(heap, thread_count);
+            if (!best.has_value() || result.total() < best->total()) {
+                best = result;
+            }
+        }
+
+        std::printf(
+            "%7zu %9.1f %9.1f %9.1f %9.1f %12.0f %11zu %11zu %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+            thread_count, milliseconds{best->scanning}.count(), milliseconds{best->naming}.count(),
+            milliseconds{best->building}.count(), milliseconds{best->total()}.count(),
+            static_cast<double>(best->refs_found) / seconds{best->scanning}.count(),
+            best->refs_found, best->refs_kept,
+            static_cast<double>(best->graph_memory) / bytes_per_mib,
+            static_cast<double>(best->file_size) / bytes_per_mib,
+            milliseconds{best->encoding}.count(), milliseconds{best->decoding}.count(),
+            static_cast<double>(best->peak_memory) / bytes_per_mib);
+        analysis_results.emplace_back(thread_count, best->analysis);
+    }
+
+    std::printf("\n%7s %9s %9s %9s %9s %9s %9s %9s %9s %9s\n", "threads", "roots ms", "reach ms",
+                "dom ms", "cycles ms", "paths ms", "k-hop ms", "group ms", "diff ms", "total ms");
+    for (const auto& [thread_count, analysis] : analysis_results) {
+        std::printf("%7zu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", thread_count,
+                    milliseconds{analysis.roots}.count(),
+                    milliseconds{analysis.unreachable}.count(),
+                    milliseconds{analysis.dominators}.count(),
+                    milliseconds{analysis.cycles}.count(), milliseconds{analysis.paths}.count(),
+                    milliseconds{analysis.neighbourhood}.count(),
+                    milliseconds{analysis.grouping}.count(), milliseconds{analysis.diff}.count(),
+                    milliseconds{analysis.total()}.count());
+    }
+
+    return 0;
+}
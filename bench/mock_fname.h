@@ -0,0 +1,53 @@
+#ifndef MOCK_FNAME_H
+#define MOCK_FNAME_H
+
+namespace unrealsdk::unreal {
+
+/**
+ * @brief Just enough of an FName to build path names with.
+ * @note Like the real thing, it's an index into a global name table, plus a number suffix.
+ */
+class FName {
+   public:
+    FName(void) = default;
+
+    /**
+     * @brief Creates a new name.
+     *
+     * @param index The index of the base name, as returned from `add_base_name`.
+     * @param number The number suffix. Zero for none, otherwise one more than the displayed suffix.
+     */
+    FName(uint32_t index, uint32_t number) : index(index), number(number) {}
+
+    /**
+     * @brief Adds a new base name to the global name table.
+     * @note Not thread safe. All names must be added before any are converted to strings.
+     *
+     * @param name The base name.
+     * @return The base name's index.
+     */
+    static uint32_t add_base_name(std::string name) {
+        base_names.push_back(std::move(name));
+        return static_cast<uint32_t>(base_names.size() - 1);
+    }
+
+    explicit operator std::string() const {
+        const auto& base = base_names[this->index];
+        if (this->number == 0) {
+            return base;
+        }
+        return base + "_" + std::to_string(this->number - 1);
+    }
+
+    bool operator==(const FName& other) const = default;
+
+   private:
+    static inline std::vector<std::string> base_names{};
+
+    uint32_t index = 0;
+    uint32_t number = 0;
+};
+
+}  // namespace unrealsdk::unreal
+
+#endif /* MOCK_FNAME_H */
@@ -0,0 +1,227 @@
+#include "pch.h"
+#include "mock_heap.h"
+
+using unrealsdk::unreal::FName;
+
+namespace live_object_explorer::bench {
+
+namespace {
+
+constexpr uint32_t PACKAGE_LAYOUT = 0;
+constexpr uint32_t CLASS_LAYOUT = 1;
+constexpr uint32_t FIRST_INSTANCE_LAYOUT = 2;
+
+// Core, Class, and Package
+constexpr size_t NUM_BUILTIN_OBJECTS = 3;
+
+/**
+ * @brief Rounds a size up to pointer alignment.
+ *
+ * @param size The size.
+ * @return The aligned size.
+ */
+constexpr size_t align_size(size_t size) {
+    return (size + alignof(void*) - 1) & ~(alignof(void*) - 1);
+}
+
+/**
+ * @brief Generates the layouts of every class.
+ *
+ * @param config The heap config.
+ * @param rng The random number generator to use.
+ * @param parents Filled with the index of each generated class's parent, or the class's own index
+ *                if it has none.
+ * @return The layouts, starting with the package and class layouts.
+ */
+std::vector<MockLayout> generate_layouts(const MockHeapConfig& config,
+                                         std::mt19937_64& rng,
+                                         std::vector<size_t>& parents) {
+    std::vector<MockLayout> layouts{};
+    layouts.push_back({.object_offsets = {}, .array_offsets = {}, .size = sizeof(MockObject)});
+    // Classes just ref their super class
+    layouts.push_back({.object_offsets = {sizeof(MockObject)},
+                       .array_offsets = {},
+                       .size = sizeof(MockObject) + sizeof(void*)});
+
+    std::uniform_int_distribution<size_t> object_props_dist{0, config.object_props * 2};
+    std::uniform_int_distribution<size_t> array_props_dist{0, config.array_props * 2};
+
+    std::vector<size_t> depths{};
+    for (size_t i = 0; i < config.classes; i++) {
+        auto parent = i;
+        size_t depth = 0;
+        if (i != 0) {
+            auto candidate = std::uniform_int_distribution<size_t>{0, i - 1}(rng);
+            if (depths[candidate] + 1 < config.max_class_depth) {
+                parent = candidate;
+                depth = depths[candidate] + 1;
+            }
+        }
+        parents.push_back(parent);
+        depths.push_back(depth);
+
+        auto layout = parent == i ? layouts[PACKAGE_LAYOUT]
+                                  : layouts[FIRST_INSTANCE_LAYOUT + parent];
+        for (auto props = object_props_dist(rng); props > 0; props--) {
+            layout.object_offsets.push_back(layout.size);
+            layout.size += sizeof(void*);
+        }
+        for (auto props = array_props_dist(rng); props > 0; props--) {
+            layout.array_offsets.push_back(layout.size);
+            layout.size += sizeof(MockArray);
+        }
+        layouts.push_back(std::move(layout));
+    }
+
+    return layouts;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+MockHeap::MockHeap(const MockHeapConfig& config) {
+    std::mt19937_64 rng{config.seed};
+
+    std::vector<size_t> parents{};
+    this->layouts = generate_layouts(config, rng, parents);
+
+    // Work out the layout of every object up front, so we can allocate them all at once
+    auto num_packages = std::max<size_t>(config.packages, 1);
+    auto first_class = NUM_BUILTIN_OBJECTS;
+    auto first_package = first_class + config.classes;
+    auto first_instance = first_package + num_packages - 1;
+    auto num_objects = first_instance + config.objects;
+
+    std::vector<uint32_t> object_layouts(num_objects, CLASS_LAYOUT);
+    object_layouts[0] = PACKAGE_LAYOUT;
+    std::fill(object_layouts.begin() + static_cast<ptrdiff_t>(first_package),
+              object_layouts.begin() + static_cast<ptrdiff_t>(first_instance), PACKAGE_LAYOUT);
+    std::uniform_int_distribution<uint32_t> class_dist{
+        0, static_cast<uint32_t>(std::max<size_t>(config.classes, 1) - 1)};
+    for (auto i = first_instance; i < num_objects; i++) {
+        object_layouts[i] = config.classes == 0 ? PACKAGE_LAYOUT
+                                                : FIRST_INSTANCE_LAYOUT + class_dist(rng);
+    }
+
+    size_t total_size = 0;
+    for (auto layout_idx : object_layouts) {
+        total_size += align_size(this->layouts[layout_idx].size);
+    }
+    this->object_memory = std::make_unique<uint8_t[]>(total_size);
+
+    this->objects.reserve(num_objects);
+    std::vector<MockObject*> mutable_objects{};
+    mutable_objects.reserve(num_objects);
+    size_t offset = 0;
+    for (auto layout_idx : object_layouts) {
+        auto obj = new (&this->object_memory[offset]) MockObject{};
+        obj->layout_idx = layout_idx;
+        this->objects.push_back(obj);
+        mutable_objects.push_back(obj);
+        offset += align_size(this->layouts[layout_idx].size);
+    }
+
+    auto set_slot = [](MockObject* obj, uint32_t slot_offset, const MockObject* value) {
+        *reinterpret_cast<const MockObject**>(reinterpret_cast<uint8_t*>(obj) + slot_offset) =
+            value;
+    };
+
+    // Builtins
+    auto core = mutable_objects[0];
+    auto class_cls = mutable_objects[1];
+    auto package_cls = mutable_objects[2];
+    this->package_cls = package_cls;
+
+    core->cls = package_cls;
+    core->name = FName{FName::add_base_name("Core"), 0};
+    class_cls->cls = class_cls;
+    class_cls->outer = core;
+    class_cls->name = FName{FName::add_base_name("Class"), 0};
+    package_cls->cls = class_cls;
+    package_cls->outer = core;
+    package_cls->name = FName{FName::add_base_name("Package"), 0};
+
+    // Classes
+    std::vector<uint32_t> class_names{};
+    for (size_t i = 0; i < config.classes; i++) {
+        auto obj = mutable_objects[first_class + i];
+        obj->cls = class_cls;
+        obj->outer = core;
+        class_names.push_back(FName::add_base_name("MockClass" + std::to_string(i)));
+        obj->name = FName{class_names.back(), 0};
+        set_slot(obj, sizeof(MockObject),
+                 parents[i] == i ? nullptr : mutable_objects[first_class + parents[i]]);
+    }
+
+    // Packages
+    auto package_name = FName::add_base_name("MockPackage");
+    for (auto i = first_package; i < first_instance; i++) {
+        auto obj = mutable_objects[i];
+        obj->cls = package_cls;
+        obj->name = FName{package_name, static_cast<uint32_t>(i - first_package + 1)};
+    }
+
+    // Instances
+    std::uniform_int_distribution<size_t> package_dist{0, num_packages - 1};
+    std::uniform_int_distribution<size_t> target_dist{0, num_objects - 1};
+    std::uniform_int_distribution<size_t> array_size_dist{0, config.array_size * 2};
+    std::bernoulli_distribution null_dist{config.null_chance};
+    std::bernoulli_distribution nested_dist{config.nested_chance};
+
+    auto random_target = [&]() -> const MockObject* {
+        return null_dist(rng) ? nullptr : this->objects[target_dist(rng)];
+    };
+
+    // Arrays point into a shared buffer which may reallocate while we're filling it, so only fix
+    // up their data pointers at the end
+    std::vector<std::pair<MockArray*, size_t>> array_starts{};
+
+    for (auto i = first_instance; i < num_objects; i++) {
+        auto obj = mutable_objects[i];
+        auto class_idx = obj->layout_idx - FIRST_INSTANCE_LAYOUT;
+        obj->cls = config.classes == 0 ? package_cls : mutable_objects[first_class + class_idx];
+        if (i != first_instance && nested_dist(rng)) {
+            obj->outer = this->objects[std::uniform_int_distribution<size_t>{first_instance,
+                                                                             i - 1}(rng)];
+        } else {
+            // Core is package zero, the rest are all in one block
+            auto package = package_dist(rng);
+            obj->outer = this->objects[package == 0 ? 0 : first_package + package - 1];
+        }
+        obj->name = config.classes == 0
+                        ? FName{package_name, static_cast<uint32_t>(i + 1)}
+                        : FName{class_names[class_idx], static_cast<uint32_t>(i + 1)};
+
+        const auto& layout = this->layouts[obj->layout_idx];
+        for (auto slot_offset : layout.object_offsets) {
+            set_slot(obj, slot_offset, random_target());
+        }
+        for (auto slot_offset : layout.array_offsets) {
+            auto arr = reinterpret_cast<MockArray*>(reinterpret_cast<uint8_t*>(obj) + slot_offset);
+            arr->count = static_cast<int32_t>(array_size_dist(rng));
+            arr->max = arr->count;
+            array_starts.emplace_back(arr, this->array_memory.size());
+            for (int32_t j = 0; j < arr->count; j++) {
+                this->array_memory.push_back(random_target());
+            }
+        }
+    }
+
+    for (auto [arr, start] : array_starts) {
+        arr->data = this->array_memory.data() + start;
+    }
+}
+
+size_t MockHeap::size(void) const {
+    return this->objects.size();
+}
+
+const MockObject* MockHeap::obj_at(size_t idx) const {
+    return this->objects[idx];
+}
+
+const MockObject* MockHeap::package_class(void) const {
+    return this->package_cls;
+}
+
+}  // namespace live_object_explorer::bench
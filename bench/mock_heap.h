@@ -0,0 +1,134 @@
+#ifndef MOCK_HEAP_H
+#define MOCK_HEAP_H
+
+#include "pch.h"
+
+namespace live_object_explorer::bench {
+
+/**
+ * @brief Settings controlling the shape of a mock heap.
+ */
+struct MockHeapConfig {
+    // How many instance objects to create, on top of the packages and classes
+    size_t objects = 1'000'000;
+    // How many packages objects get spread across
+    size_t packages = 2'000;
+    // How many classes there are, and how deep the inheritance tree can get
+    size_t classes = 1'000;
+    size_t max_class_depth = 6;
+    // How many object reference, and array, properties each class adds on top of it's parent
+    size_t object_props = 2;
+    size_t array_props = 1;
+    // The average length of each array
+    size_t array_size = 4;
+    // The chance of an object reference being null, controlling how dense the graph is
+    double null_chance = 0.3;
+    // The chance an instance is nested inside another instance, rather than directly in a package
+    double nested_chance = 0.4;
+    uint64_t seed = 1;
+};
+
+/**
+ * @brief The compiled list of reference slots in a mock class, including it's parents'.
+ * @note Equivalent to a `RefLayout`, only containing object references and arrays of them.
+ */
+struct MockLayout {
+    std::vector<uint32_t> object_offsets;
+    std::vector<uint32_t> array_offsets;
+    uint32_t size;
+};
+
+/**
+ * @brief A mock object's header. The object's properties follow directly after it.
+ */
+struct MockObject {
+    const MockObject* cls;
+    const MockObject* outer;
+    unrealsdk::unreal::FName name;
+    uint32_t layout_idx;
+};
+
+/**
+ * @brief A mock array property's value, laid out like a TArray.
+ */
+struct MockArray {
+    const MockObject** data;
+    int32_t count;
+    int32_t max;
+};
+
+/**
+ * @brief A randomly generated heap of objects, standing in for GObjects.
+ */
+class MockHeap {
+   public:
+    /**
+     * @brief Generates a new heap.
+     *
+     * @param config The settings to generate it with.
+     */
+    explicit MockHeap(const MockHeapConfig& config);
+
+    /**
+     * @brief Gets the total amount of objects, including packages and classes.
+     *
+     * @return The number of objects.
+     */
+    [[nodiscard]] size_t size(void) const;
+
+    /**
+     * @brief Gets an object by it's index, as in `GObjects::obj_at`.
+     *
+     * @param idx The index.
+     * @return The object.
+     */
+    [[nodiscard]] const MockObject* obj_at(size_t idx) const;
+
+    /**
+     * @brief Gets the package class.
+     *
+     * @return The package class object.
+     */
+    [[nodiscard]] const MockObject* package_class(void) const;
+
+    /**
+     * @brief Searches for all the references an object holds.
+     * @note Mirrors `search_for_refs` - walks the object's compiled layout, reading pointers out of
+     *       it at fixed offsets.
+     *
+     * @tparam Sink The type of the sink. Called with the from and to objects of each ref.
+     * @param obj The object to search.
+     * @param sink The sink to pass any discovered refs to. May be passed null refs.
+     */
+    template <typename Sink>
+    void search_for_refs(const MockObject* obj, Sink& sink) const {
+        // Every object refs it's class and outer, like the native fields on a real UObject
+        sink(obj, obj->cls);
+        sink(obj, obj->outer);
+
+        const auto& layout = this->layouts[obj->layout_idx];
+        auto base = reinterpret_cast<const uint8_t*>(obj);
+        for (auto offset : layout.object_offsets) {
+            sink(obj, *reinterpret_cast<const MockObject* const*>(base + offset));
+        }
+        for (auto offset : layout.array_offsets) {
+            const auto& arr = *reinterpret_cast<const MockArray*>(base + offset);
+            for (int32_t i = 0; i < arr.count; i++) {
+                sink(obj, arr.data[i]);
+            }
+        }
+    }
+
+   private:
+    std::vector<MockLayout> layouts;
+    std::vector<const MockObject*> objects;
+    const MockObject* package_cls = nullptr;
+
+    // Objects are bump allocated out of here, in gobjects order, like a real allocator mostly does
+    std::unique_ptr<uint8_t[]> object_memory;
+    std::vector<const MockObject*> array_memory;
+};
+
+}  // namespace live_object_explorer::bench
+
+#endif /* MOCK_HEAP_H */
@@ -0,0 +1,52 @@
+#ifndef PCH_H
+#define PCH_H
+
+// Stands in for the real pch, which pulls in windows, unrealsdk, and imgui. Only provides what the
+// unrealsdk-independent parts of the refs engine need.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __has_include(<format>)
+#include <format>
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define LOG(level, ...) (std::cerr << "[" #level "] " << std::format(__VA_ARGS__) << '\n')
+#else
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define LOG(level, fmt, ...) (std::cerr << "[" #level "] " << (fmt) << '\n')
+#endif
+
+#include "mock_fname.h"
+
+#endif /* PCH_H */
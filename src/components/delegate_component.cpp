@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "components/delegate_component.h"
 #include "components/abstract.h"
+#include "function_cache.h"
 #include "object_link.h"
 #include "object_window.h"
 #include "string_helper.h"
@@ -131,21 +132,13 @@ void DelegateComponent::draw(const ObjectWindowSettings& settings,
             ImGui::TextDisabled("%s", this->cached_func_name.c_str());
         } else {
             object_link(this->cached_func_name, [&]() -> FFieldVariant {
-                try {
-                    // Well you know that big comment about always keeping objects valid? Turns out
-                    // the game doesn't always do so, it is possible for this find call to fail.
-                    auto ret = current_obj->Class()->find(this->last_func_name);
-
-                    // Need to re-convert to a FFieldVariant, since find may return a stub, and it
-                    // always returns a UStruct rather than a UObject
-                    if (ret.is_ffield()) {
-                        return ret.as_ffield();
-                    }
-                    return ret.as_uobject();
-                } catch (...) {
+                // Well you know that big comment about always keeping objects valid? Turns out the
+                // game doesn't always do so, it is possible for this lookup to fail.
+                auto func = find_delegate_function(current_obj->Class(), this->last_func_name);
+                if (func == nullptr) {
                     this->known_bad_func_name = true;
-                    return nullptr;
                 }
+                return func;
             });
         }
         ImGui::SameLine();
@@ -113,15 +113,18 @@ DWORD WINAPI live_oe_startup(LPVOID /*unused*/) {
  * @return True if loaded successfully, false otherwise.
  */
 // NOLINTNEXTLINE(misc-use-internal-linkage, readability-identifier-naming)
-BOOL APIENTRY DllMain(HMODULE h_module, DWORD ul_reason_for_call, LPVOID /*unused*/) {
+BOOL APIENTRY DllMain(HMODULE h_module, DWORD ul_reason_for_call, LPVOID lp_reserved) {
     switch (ul_reason_for_call) {
         case DLL_PROCESS_ATTACH:
             DisableThreadLibraryCalls(h_module);
             CreateThread(nullptr, 0, &live_object_explorer::live_oe_startup, nullptr, 0, nullptr);
             break;
+        case DLL_PROCESS_DETACH:
+            // Reserved is only null when being unloaded dynamically, not when the process exits
+            live_object_explorer::refs::shutdown(lp_reserved != nullptr);
+            break;
         case DLL_THREAD_ATTACH:
         case DLL_THREAD_DETACH:
-        case DLL_PROCESS_DETACH:
             break;
     }
     return TRUE;
@@ -0,0 +1,100 @@
+#include "pch.h"
+#include "function_cache.h"
+
+using namespace unrealsdk::unreal;
+
+namespace live_object_explorer {
+
+namespace {
+
+struct CacheEntry {
+    // The class's GObjects index, used to notice if it was unloaded and something else reused it's
+    // address. A weak pointer would be simpler, but creating one writes into GObjects, which isn't
+    // safe from the snapshot threads while the game is suspended.
+    int32_t cls_idx;
+    FFieldVariant func;
+};
+
+// Plenty for every delegate in a heap, just stops the cache growing forever across a long session
+const constexpr size_t MAX_CACHE_ENTRIES = 0x10000;
+
+std::shared_mutex cache_mutex;
+std::unordered_map<FunctionKey, CacheEntry, FunctionKeyHash> cache;
+
+/**
+ * @brief Checks if a cache entry's class is still loaded, by reading it back out of GObjects.
+ *
+ * @param entry The cache entry.
+ * @param cls The class we're looking up.
+ * @return True if the entry is still valid.
+ */
+bool is_class_loaded(const CacheEntry& entry, UClass* cls) {
+    const auto& gobjects = unrealsdk::gobjects();
+    return entry.cls_idx >= 0 && static_cast<size_t>(entry.cls_idx) < gobjects.size()
+           && gobjects.obj_at(entry.cls_idx) == cls;
+}
+
+/**
+ * @brief Looks up a function, bypassing the cache.
+ *
+ * @param cls The class to look up the function on.
+ * @param func_name The name of the function.
+ * @return The function, or null if it couldn't be found.
+ */
+FFieldVariant resolve_function(UClass* cls, const FName& func_name) {
+    try {
+        // The game can create invalid delegates sometimes, meaning this find call can fail
+        auto ret = cls->find(func_name);
+
+        // Need to re-convert to a FFieldVariant, since find may return a stub, and it always
+        // returns a UStruct rather than a UObject
+        if (ret.is_ffield()) {
+            return ret.as_ffield();
+        }
+        return ret.as_uobject();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+}  // namespace
+
+FunctionKey FunctionKey::make(UClass* cls, const FName& func_name) {
+    static_assert(sizeof(FName) == sizeof(uint64_t));
+    uint64_t name = 0;
+    memcpy(&name, &func_name, sizeof(name));
+    return {.cls = cls, .name = name};
+}
+
+size_t FunctionKeyHash::operator()(const FunctionKey& key) const {
+    const constexpr uint64_t multiplier = 0x9E3779B97F4A7C15;
+    return static_cast<size_t>((reinterpret_cast<uintptr_t>(key.cls) * multiplier) ^ key.name);
+}
+
+FFieldVariant find_delegate_function(UClass* cls, const FName& func_name) {
+    auto key = FunctionKey::make(cls, func_name);
+    {
+        const std::shared_lock lock{cache_mutex};
+        auto iter = cache.find(key);
+        if (iter != cache.end() && is_class_loaded(iter->second, cls)) {
+            return iter->second.func;
+        }
+    }
+
+    // Resolve outside of the lock, if two threads race on the same pair they'll get the same result
+    auto func = resolve_function(cls, func_name);
+
+    const std::unique_lock lock{cache_mutex};
+    if (cache.size() >= MAX_CACHE_ENTRIES) {
+        cache.clear();
+    }
+    cache.insert_or_assign(key, CacheEntry{.cls_idx = cls->InternalIndex(), .func = func});
+    return func;
+}
+
+void clear_function_cache(void) {
+    const std::unique_lock lock{cache_mutex};
+    cache.clear();
+}
+
+}  // namespace live_object_explorer
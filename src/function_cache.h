@@ -0,0 +1,56 @@
+#ifndef FUNCTION_CACHE_H
+#define FUNCTION_CACHE_H
+
+#include "pch.h"
+
+namespace live_object_explorer {
+
+/**
+ * @brief Identifies a function lookup, a class and the name of the function to find on it.
+ */
+struct FunctionKey {
+    unrealsdk::unreal::UClass* cls;
+    uint64_t name;
+
+    /**
+     * @brief Creates a new key.
+     *
+     * @param cls The class to look up the function on.
+     * @param func_name The name of the function.
+     * @return The key.
+     */
+    static FunctionKey make(unrealsdk::unreal::UClass* cls,
+                            const unrealsdk::unreal::FName& func_name);
+
+    bool operator==(const FunctionKey& other) const = default;
+};
+
+struct FunctionKeyHash {
+    size_t operator()(const FunctionKey& key) const;
+};
+
+/**
+ * @brief Finds the function a delegate bound to an object of the given class would call.
+ * @note Thread safe. Results are cached in a single shared cache, including failed lookups, so
+ *       each pair only walks the class's fields (and potentially throws) once, rather than once
+ *       per delegate.
+ * @note Entries remember the class's GObjects index, so if the class gets unloaded and something
+ *       else reuses it's address, we notice and look it up again. Only ever reads from GObjects, so
+ *       is safe to call while the game is suspended.
+ *
+ * @param cls The class to look up the function on.
+ * @param func_name The name of the function.
+ * @return The function, or null if it couldn't be found.
+ */
+unrealsdk::unreal::FFieldVariant find_delegate_function(unrealsdk::unreal::UClass* cls,
+                                                        const unrealsdk::unreal::FName& func_name);
+
+/**
+ * @brief Clears the shared function cache.
+ * @note Called at the start of each snapshot, so the cache only ever holds what's been seen since.
+ */
+void clear_function_cache(void);
+
+}  // namespace live_object_explorer
+
+#endif /* FUNCTION_CACHE_H */
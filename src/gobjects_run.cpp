@@ -0,0 +1,22 @@
+#include "pch.h"
+#include "gobjects_run.h"
+
+using namespace unrealsdk::unreal;
+
+namespace live_object_explorer {
+
+GObjectsRun::GObjectsRun(void) : gobjects(unrealsdk::gobjects()) {}
+
+void GObjectsRun::gather(size_t start_idx, size_t end_idx) {
+    this->entries.clear();
+
+    end_idx = std::min(end_idx, this->gobjects.size());
+    for (auto i = start_idx; i < end_idx; i++) {
+        auto obj = this->gobjects.obj_at(i);
+        if (obj != nullptr) {
+            this->entries.push_back({.idx = i, .obj = obj});
+        }
+    }
+}
+
+}  // namespace live_object_explorer
@@ -0,0 +1,66 @@
+#ifndef GOBJECTS_RUN_H
+#define GOBJECTS_RUN_H
+
+#include "pch.h"
+
+namespace live_object_explorer {
+
+/**
+ * @brief A contiguous run of all the valid objects within a range of GObjects.
+ * @note Meant to be reused for each chunk of a larger walk, to avoid reallocating.
+ */
+class GObjectsRun {
+   public:
+    struct Entry {
+        size_t idx;
+        unrealsdk::unreal::UObject* obj;
+    };
+
+    /**
+     * @brief Creates a new, empty, run.
+     */
+    GObjectsRun(void);
+
+    /**
+     * @brief Gathers all valid objects in a range of GObjects, replacing the previous run.
+     * @note Never throws, the range is clamped to the current size of GObjects up front, so we
+     *       never need to check each index individually.
+     *
+     * @param start_idx The first index to gather.
+     * @param end_idx One past the last index to gather.
+     */
+    void gather(size_t start_idx, size_t end_idx);
+
+    /**
+     * @brief Calls a function on each object in the run, in index order.
+     * @note Prefetches objects a short distance ahead, so their headers are hopefully already in
+     *       cache by the time we get to them.
+     *
+     * @param func The function to call. Gets passed a const reference to each entry.
+     */
+    template <typename F>
+    void for_each(F&& func) const {
+        auto num_entries = this->entries.size();
+        for (size_t i = 0; i < std::min(num_entries, PREFETCH_DISTANCE); i++) {
+            PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, this->entries[i].obj);
+        }
+        for (size_t i = 0; i < num_entries; i++) {
+            if (i + PREFETCH_DISTANCE < num_entries) {
+                PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, this->entries[i + PREFETCH_DISTANCE].obj);
+            }
+            func(this->entries[i]);
+        }
+    }
+
+   private:
+    // Far enough ahead to hide a cache miss behind processing the objects before it, close enough
+    // that it won't be evicted again before we get to it
+    static constexpr size_t PREFETCH_DISTANCE = 8;
+
+    unrealsdk::unreal::GObjects gobjects;
+    std::vector<Entry> entries;
+};
+
+}  // namespace live_object_explorer
+
+#endif /* GOBJECTS_RUN_H */
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "gui.h"
 #include "components/abstract.h"
+#include "gobjects_run.h"
 #include "object_window.h"
 #include "refs.h"
 
@@ -25,11 +26,29 @@ enum SearchMode {
     SM_SNAPSHOT_ENTRIES,
     SM_REFERENCES_TO,
     SM_REFERENCES_FROM,
+    SM_PATH_FROM_ROOTS,
+    SM_TOP_RETAINERS,
+    SM_SNAPSHOT_DIFF,
+    SM_CYCLES,
+    SM_UNREACHABLE,
+};
+
+// NOLINTNEXTLINE(performance-enum-size, cppcoreguidelines-use-enum-class)
+enum GroupMode {
+    GM_NONE,
+    GM_CLASS,
+    GM_PACKAGE,
 };
 
 bool search_window_open = false;
 int search_mode = SearchMode::SM_LIVE;
+int group_mode = GroupMode::GM_NONE;
+// One of the `refs::RootSet` values
+int root_set = static_cast<int>(refs::RootSet::FLAGGED);
 bool highlight_take_snapshot = false;
+bool incremental_snapshot = true;
+bool ignore_native_refs = true;
+int ref_depth = 1;
 
 using time_point = std::chrono::time_point<std::chrono::steady_clock>;
 time_point last_snapshot_time = time_point::min();
@@ -38,9 +57,24 @@ std::string last_snapshot_time_text = "Never";
 
 // NOLINTNEXTLINE(readability-magic-numbers)
 std::array<char, 1024> search_query{};
+// NOLINTNEXTLINE(readability-magic-numbers)
+std::array<char, 1024> root_query{};
+// NOLINTNEXTLINE(readability-magic-numbers)
+std::array<char, 256> save_snapshot_name{};
+// NOLINTNEXTLINE(readability-magic-numbers)
+std::array<char, 256> class_filter{};
 
+// The names of the saved snapshots to diff, empty for the current one
+std::string diff_before_name{};
+std::string diff_after_name{};
+
+// Searches only ever fill one of the flat results, the groups, or the retainers
 std::vector<SearchResult> search_results{};
-size_t selected_search_idx = 0;
+std::vector<SearchResultGroup> search_groups{};
+std::vector<RetainerResult> retainer_results{};
+// Set when the retainers are replaced, so they get sorted to match the table again
+bool retainers_need_sort = false;
+const SearchResult* selected_search_result = nullptr;
 ImGuiTextFilter search_filter;
 
 void do_live_search(void) {
@@ -72,18 +106,54 @@ void do_live_search(void) {
         return;
     }
 
-    std::ranges::copy(unrealsdk::gobjects() | std::views::filter([cls](auto obj) {
-                          return obj->is_instance(cls);
-                      }) | std::views::transform([](auto obj) {
-                          return SearchResult{unrealsdk::utils::narrow(obj->get_path_name()), obj};
-                      }),
-                      std::back_inserter(search_results));
+    // Walk gobjects in runs, so we get prefetching while checking each object's class
+    const constexpr size_t run_size = 0x400;
+    GObjectsRun run{};
+    auto num_objects = unrealsdk::gobjects().size();
+    for (size_t start_idx = 0; start_idx < num_objects; start_idx += run_size) {
+        run.gather(start_idx, start_idx + run_size);
+        run.for_each([cls](const GObjectsRun::Entry& entry) {
+            if (entry.obj->is_instance(cls)) {
+                search_results.push_back(
+                    SearchResult{unrealsdk::utils::narrow(entry.obj->get_path_name()), entry.obj});
+            }
+        });
+    }
 }
 
 void do_search(void) {
     search_filter.Clear();
     search_results.clear();
-    selected_search_idx = 0;
+    search_groups.clear();
+    retainer_results.clear();
+    selected_search_result = nullptr;
+    // Make sure a search still running in the background doesn't add it's results to this one
+    refs::cancel_search();
+
+    // Searching more than one ref deep, or filtering by class, always groups by depth. These can
+    // walk a large chunk of the graph, so run in the background.
+    if ((search_mode == SM_REFERENCES_TO || search_mode == SM_REFERENCES_FROM)
+        && (ref_depth > 1 || class_filter.front() != '\0')) {
+        refs::start_search_refs_within(std::string_view{search_query.data()},
+                                       search_mode == SM_REFERENCES_TO ? refs::RefDirection::TO
+                                                                       : refs::RefDirection::FROM,
+                                       static_cast<size_t>(ref_depth),
+                                       std::string_view{class_filter.data()});
+        return;
+    }
+
+    if (group_mode != GroupMode::GM_NONE
+        && (search_mode == SM_REFERENCES_TO || search_mode == SM_REFERENCES_FROM)) {
+        auto group_by = group_mode == GroupMode::GM_PACKAGE ? refs::GroupBy::PACKAGE
+                                                            : refs::GroupBy::CLASS;
+        if (search_mode == SM_REFERENCES_TO) {
+            refs::search_refs_to(std::string_view{search_query.data()}, group_by, search_groups);
+        } else {
+            refs::search_refs_from(std::string_view{search_query.data()}, group_by,
+                                   search_groups);
+        }
+        return;
+    }
 
     switch (search_mode) {
         case SM_LIVE:
@@ -98,6 +168,30 @@ void do_search(void) {
         case SM_REFERENCES_FROM:
             refs::search_refs_from(std::string_view{search_query.data()}, search_results);
             break;
+        case SM_PATH_FROM_ROOTS:
+            refs::search_path_to(std::string_view{search_query.data()},
+                                 static_cast<refs::RootSet>(root_set),
+                                 std::string_view{root_query.data()}, search_results);
+            break;
+        case SM_TOP_RETAINERS:
+            refs::start_find_top_retainers(static_cast<refs::RootSet>(root_set),
+                                           std::string_view{root_query.data()});
+            break;
+        case SM_SNAPSHOT_DIFF:
+            refs::start_diff_snapshots(diff_before_name, diff_after_name);
+            break;
+        case SM_CYCLES:
+            refs::start_find_cycles(!ignore_native_refs);
+            break;
+        case SM_UNREACHABLE:
+            if (group_mode == GroupMode::GM_NONE) {
+                refs::start_find_unreachable(std::nullopt);
+            } else {
+                refs::start_find_unreachable(group_mode == GroupMode::GM_PACKAGE
+                                                 ? refs::GroupBy::PACKAGE
+                                                 : refs::GroupBy::CLASS);
+            }
+            break;
     }
 }
 
@@ -129,11 +223,342 @@ void search_refs_to(std::string_view query) {
 
 namespace {
 
+/**
+ * @brief Looks up the live object a non-live search result refers to.
+ *
+ * @param res The search result.
+ * @return The object, or nullptr if it doesn't exist.
+ */
+UObject* find_non_live_result(const SearchResult& res) {
+    // Try the slot it was last seen in first, since finding by name has to check every object
+    // The slot may have been reused by now though, so make sure it still holds the same object
+    if (res.gobjects_idx != SearchResult::UNKNOWN_GOBJECTS_IDX
+        && res.gobjects_idx < unrealsdk::gobjects().size()) {
+        auto obj = unrealsdk::gobjects().obj_at(res.gobjects_idx);
+        if (obj != nullptr && unrealsdk::utils::narrow(obj->get_path_name()) == res.name) {
+            return obj;
+        }
+    }
+    return unrealsdk::find_object(L"Object", unrealsdk::utils::widen(res.name));
+}
+
+/**
+ * @brief Draws a single search result.
+ *
+ * @param res The search result.
+ */
+void draw_search_result(SearchResult& res) {
+    const bool disabled = (res.flags & SearchResult::NOT_LIVE) == 0 && !res.ptr;
+    const bool is_selected = selected_search_result == &res;
+
+    // If the lookup failed, copy the disabled styling, but don't actually disable it
+    // This means you can select it again later, to check if it exists then
+    auto old_alpha = ImGui::GetStyle().Alpha;
+    if (!disabled && (res.flags & SearchResult::LOOKUP_FAILED) != 0) {
+        ImGui::GetStyle().Alpha *= ImGui::GetStyle().DisabledAlpha;
+    }
+
+    if (ImGui::Selectable(res.name.c_str(), is_selected,
+                          disabled ? ImGuiSelectableFlags_Disabled : 0)) {
+        selected_search_result = &res;
+    }
+    auto item_hovered = ImGui::IsItemHovered();
+    if (!res.note.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", res.note.c_str());
+    }
+
+    ImGui::GetStyle().Alpha = old_alpha;
+
+    if (is_selected) {
+        ImGui::SetItemDefaultFocus();
+    }
+
+    if (item_hovered
+        && (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)
+            || ImGui::IsKeyPressed(ImGuiKey_Enter))) {
+        if ((res.flags & SearchResult::NOT_LIVE) == 0) {
+            if (!disabled) {
+                open_object_window(*(res.ptr));
+            }
+        } else {
+            // Allow searching for a disabled object again, in case it exists now
+            auto obj = find_non_live_result(res);
+            if (obj == nullptr) {
+                res.flags |= SearchResult::LOOKUP_FAILED;
+            } else {
+                res.flags &= ~SearchResult::LOOKUP_FAILED;
+                open_object_window(obj);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Draws a group of search results, filling it in if it's expanded for the first time.
+ *
+ * @param group The group to draw.
+ */
+void draw_search_result_group(SearchResultGroup& group) {
+    // Results are never modified after loading, so it's safe to point the selection into them
+    if (!ImGui::TreeNode(&group, "%s (%zu)", group.name.c_str(), group.count)) {
+        return;
+    }
+    if (!group.loaded) {
+        group.load_results(group.results);
+        group.loaded = true;
+    }
+    for (auto& res : group.results) {
+        draw_search_result(res);
+    }
+    ImGui::TreePop();
+}
+
+/**
+ * @brief Formats a size in bytes into a human readable string.
+ *
+ * @param bytes The size.
+ * @return The formatted size.
+ */
+std::string format_size(uint64_t bytes) {
+    const constexpr uint64_t kib = 1024;
+    const constexpr uint64_t mib = kib * 1024;
+    if (bytes >= mib) {
+        return std::format("{:.1f} MiB", static_cast<double>(bytes) / static_cast<double>(mib));
+    }
+    if (bytes >= kib) {
+        return std::format("{:.1f} KiB", static_cast<double>(bytes) / static_cast<double>(kib));
+    }
+    return std::format("{} B", bytes);
+}
+
+/**
+ * @brief Draws the top retainers results, as a sortable table.
+ *
+ * @param size The size of the table.
+ */
+void draw_retainers_table(const ImVec2& size) {
+    if (!ImGui::BeginTable("##top_retainers", 3,
+                           ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY
+                               | ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersInnerV
+                               | ImGuiTableFlags_RowBg,
+                           size)) {
+        return;
+    }
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Object", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Shallow",
+                            ImGuiTableColumnFlags_WidthFixed
+                                | ImGuiTableColumnFlags_PreferSortDescending);
+    ImGui::TableSetupColumn("Retained", ImGuiTableColumnFlags_WidthFixed
+                                            | ImGuiTableColumnFlags_DefaultSort
+                                            | ImGuiTableColumnFlags_PreferSortDescending);
+    ImGui::TableHeadersRow();
+
+    auto sort_specs = ImGui::TableGetSortSpecs();
+    if (sort_specs != nullptr && sort_specs->SpecsCount > 0
+        && (sort_specs->SpecsDirty || retainers_need_sort)) {
+        const auto& spec = sort_specs->Specs[0];
+        auto compare = [&spec](const RetainerResult& lhs, const RetainerResult& rhs) {
+            switch (spec.ColumnIndex) {
+                case 0:
+                    return lhs.result.name < rhs.result.name;
+                case 1:
+                    return lhs.shallow_size < rhs.shallow_size;
+                default:
+                    return lhs.retained_size < rhs.retained_size;
+            }
+        };
+        if (spec.SortDirection == ImGuiSortDirection_Descending) {
+            std::ranges::stable_sort(retainer_results,
+                                     [&compare](const auto& lhs, const auto& rhs) {
+                                         return compare(rhs, lhs);
+                                     });
+        } else {
+            std::ranges::stable_sort(retainer_results, compare);
+        }
+
+        // The selection points into the results, which just moved around
+        selected_search_result = nullptr;
+        sort_specs->SpecsDirty = false;
+        retainers_need_sort = false;
+    }
+
+    for (auto& retainer : retainer_results) {
+        if (!search_filter.PassFilter(retainer.result.name.c_str())) {
+            continue;
+        }
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        draw_search_result(retainer.result);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(format_size(retainer.shallow_size).c_str());
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(format_size(retainer.retained_size).c_str());
+    }
+
+    ImGui::EndTable();
+}
+
+/**
+ * @brief Draws a combo box to pick one of the saved snapshots, or the current one.
+ *
+ * @param label The combo's label.
+ * @param saved_snapshots The names of all saved snapshots.
+ * @param selected The name of the selected snapshot, empty for the current one. Reset if the
+ *                 snapshot no longer exists.
+ */
+void draw_snapshot_combo(const char* label,
+                         const std::vector<std::string>& saved_snapshots,
+                         std::string& selected) {
+    if (!selected.empty() && !std::ranges::binary_search(saved_snapshots, selected)) {
+        selected.clear();
+    }
+
+    if (!ImGui::BeginCombo(label, selected.empty() ? "Current" : selected.c_str())) {
+        return;
+    }
+    if (ImGui::Selectable("Current", selected.empty())) {
+        selected.clear();
+    }
+    for (const auto& name : saved_snapshots) {
+        if (ImGui::Selectable(name.c_str(), name == selected)) {
+            selected = name;
+        }
+    }
+    ImGui::EndCombo();
+}
+
+/**
+ * @brief Draws the list of saved snapshots, and the controls to save new ones.
+ *
+ * @param saved_snapshots The names of all saved snapshots.
+ */
+void draw_saved_snapshots(const std::vector<std::string>& saved_snapshots) {
+    auto text_size = ImGui::CalcTextSize("Save");
+    auto button_width = text_size.x + (2 * ImGui::GetStyle().FramePadding.x)
+                        + ImGui::GetStyle().ItemSpacing.x;
+
+    ImGui::BeginDisabled(!refs::has_snapshot());
+    ImGui::SetNextItemWidth(-button_width);
+    ImGui::InputTextWithHint("##save_snapshot_name", "Name to save current snapshot as",
+                             save_snapshot_name.data(), save_snapshot_name.size());
+    ImGui::SameLine();
+    ImGui::BeginDisabled(save_snapshot_name[0] == '\0');
+    if (ImGui::Button("Save")) {
+        refs::save_snapshot(std::string_view{save_snapshot_name.data()});
+        save_snapshot_name[0] = '\0';
+    }
+    ImGui::EndDisabled();
+    ImGui::EndDisabled();
+
+    for (const auto& name : saved_snapshots) {
+        ImGui::PushID(name.c_str());
+        if (ImGui::SmallButton("Delete")) {
+            refs::delete_saved_snapshot(name);
+        }
+        ImGui::SameLine();
+        ImGui::TextUnformatted(name.c_str());
+        ImGui::PopID();
+    }
+}
+
+/**
+ * @brief Draws a progress bar for the snapshot being taken in the background.
+ *
+ * @param progress The snapshot's progress.
+ */
+void draw_snapshot_progress(const refs::SnapshotProgress& progress) {
+    auto fraction = progress.total == 0
+                        ? 0.0F
+                        : static_cast<float>(progress.done) / static_cast<float>(progress.total);
+
+    std::string overlay{};
+    switch (progress.phase) {
+        case refs::SnapshotProgress::Phase::IDLE:
+            break;
+        case refs::SnapshotProgress::Phase::SCANNING:
+            overlay = std::format("Scanning objects: {}/{}, {} refs found", progress.done,
+                                  progress.total, progress.refs_found);
+            break;
+        case refs::SnapshotProgress::Phase::NAMING:
+            overlay = std::format("Naming objects: {}/{}", progress.done, progress.total);
+            break;
+        case refs::SnapshotProgress::Phase::BUILDING:
+            fraction = 1.0F;
+            overlay = std::format("Building graph: {} refs", progress.refs_found);
+            break;
+    }
+
+    ImGui::ProgressBar(fraction, ImVec2{-FLT_MIN, 0}, overlay.c_str());
+}
+
+/**
+ * @brief Draws the stats of the last snapshot, if we have any.
+ */
+void draw_snapshot_stats(void) {
+    auto stats = refs::get_snapshot_stats();
+    if (stats == nullptr) {
+        return;
+    }
+    if (!ImGui::TreeNodeEx("Last Snapshot Stats", ImGuiTreeNodeFlags_DrawLinesFull)) {
+        return;
+    }
+
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    using seconds = std::chrono::duration<double>;
+
+    auto suspended = std::chrono::duration_cast<seconds>(stats->suspended).count();
+    ImGui::Text("%s snapshot, %u threads", stats->incremental ? "Incremental" : "Full",
+                stats->threads);
+    ImGui::Text("Suspended: %.1f ms (%.0f objects/s)",
+                std::chrono::duration_cast<milliseconds>(stats->suspended).count(),
+                suspended > 0 ? static_cast<double>(stats->objects) / suspended : 0.0);
+    ImGui::Text("Naming: %.1f ms", std::chrono::duration_cast<milliseconds>(stats->naming).count());
+    ImGui::Text("Building: %.1f ms",
+                std::chrono::duration_cast<milliseconds>(stats->building).count());
+    ImGui::Text("Objects: %zu, rescanned %zu", stats->objects, stats->objects_rescanned);
+    ImGui::Text("Refs: %zu found, %zu kept", stats->refs_found, stats->refs_kept);
+    ImGui::Text("Memory: %.1f MiB",
+                static_cast<double>(stats->memory_usage) / static_cast<double>(1024 * 1024));
+
+    if (ImGui::BeginTable("top_classes", 3,
+                          ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersInnerV
+                              | ImGuiTableFlags_NoSavedSettings)) {
+        ImGui::TableSetupColumn("Class", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Objects", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Scan Time", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+
+        for (const auto& cls : stats->top_classes) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(cls.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", cls.objects);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f ms", std::chrono::duration_cast<milliseconds>(cls.time).count());
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::TreePop();
+}
+
 /**
  * @brief Draws the search window, if applicable.
  */
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void draw_search_window(void) {
+    // Check this even while closed, so the time's accurate when next opened
+    if (refs::poll_finished_snapshot()) {
+        LOG(MISC, "Snapshot finished");
+        last_snapshot_time = next_time_text_update = std::chrono::steady_clock::now();
+    }
+    if (refs::poll_search(search_results, search_groups, retainer_results)) {
+        retainers_need_sort = true;
+    }
+
     if (!search_window_open) {
         return;
     }
@@ -180,6 +605,74 @@ void draw_search_window(void) {
             add_tooltip();
             ImGui::RadioButton("References From", &search_mode, SearchMode::SM_REFERENCES_FROM);
             add_tooltip();
+            ImGui::RadioButton("Path From Roots", &search_mode, SearchMode::SM_PATH_FROM_ROOTS);
+            add_tooltip();
+            ImGui::RadioButton("Top Retainers", &search_mode, SearchMode::SM_TOP_RETAINERS);
+            add_tooltip();
+            ImGui::RadioButton("Snapshot Diff", &search_mode, SearchMode::SM_SNAPSHOT_DIFF);
+            add_tooltip();
+            ImGui::RadioButton("Cycles", &search_mode, SearchMode::SM_CYCLES);
+            add_tooltip();
+            ImGui::RadioButton("Unreachable Objects", &search_mode, SearchMode::SM_UNREACHABLE);
+            add_tooltip();
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(search_mode != SearchMode::SM_REFERENCES_TO
+                                 && search_mode != SearchMode::SM_REFERENCES_FROM
+                                 && search_mode != SearchMode::SM_UNREACHABLE);
+            ImGui::Text("Group results by:");
+            ImGui::RadioButton("None", &group_mode, GroupMode::GM_NONE);
+            ImGui::SameLine();
+            ImGui::RadioButton("Class", &group_mode, GroupMode::GM_CLASS);
+            ImGui::SameLine();
+            ImGui::RadioButton("Package", &group_mode, GroupMode::GM_PACKAGE);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(search_mode != SearchMode::SM_REFERENCES_TO
+                                 && search_mode != SearchMode::SM_REFERENCES_FROM);
+            ImGui::Text("Depth:");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x / 3);
+            ImGui::SliderInt("##ref_depth", &ref_depth, 1, static_cast<int>(refs::MAX_REF_DEPTH));
+            ImGui::SetItemTooltip("Searching more than one ref deep groups results by depth");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(-FLT_MIN);
+            ImGui::InputTextWithHint("##class_filter", "Class filter", class_filter.data(),
+                                     class_filter.size());
+            ImGui::SetItemTooltip("Only show objects of matching classes, supports %% and _");
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(search_mode != SearchMode::SM_PATH_FROM_ROOTS
+                                 && search_mode != SearchMode::SM_TOP_RETAINERS);
+            ImGui::Text("Roots:");
+            ImGui::RadioButton("Root Set", &root_set, static_cast<int>(refs::RootSet::FLAGGED));
+            ImGui::SetItemTooltip("Objects the engine always keeps alive");
+            ImGui::SameLine();
+            ImGui::RadioButton("Singletons", &root_set,
+                               static_cast<int>(refs::RootSet::SINGLETONS));
+            ImGui::SetItemTooltip("The engine and world objects");
+            ImGui::SameLine();
+            ImGui::RadioButton("Object:", &root_set, static_cast<int>(refs::RootSet::OBJECT));
+            ImGui::SameLine();
+            ImGui::BeginDisabled(root_set != static_cast<int>(refs::RootSet::OBJECT));
+            ImGui::SetNextItemWidth(-FLT_MIN);
+            ImGui::InputText("##root_query", root_query.data(), root_query.size());
+            ImGui::EndDisabled();
+            ImGui::EndDisabled();
+
+            auto saved_snapshots = refs::get_saved_snapshots();
+            ImGui::BeginDisabled(search_mode != SearchMode::SM_SNAPSHOT_DIFF);
+            ImGui::Text("Diff snapshots:");
+            ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x / 3);
+            draw_snapshot_combo("Before", saved_snapshots, diff_before_name);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x / 2);
+            draw_snapshot_combo("After", saved_snapshots, diff_after_name);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(search_mode != SearchMode::SM_CYCLES);
+            ImGui::Checkbox("Ignore native refs", &ignore_native_refs);
+            ImGui::SetItemTooltip("Class, Outer, and the links between fields, such as Next");
             ImGui::EndDisabled();
 
             if (refs::has_snapshot()) {
@@ -199,17 +692,24 @@ void draw_search_window(void) {
                 }
             }
 
+            auto progress = refs::get_snapshot_progress();
+            const bool taking_snapshot = progress.phase != refs::SnapshotProgress::Phase::IDLE;
+            const char* snapshot_button = taking_snapshot ? "Cancel Snapshot" : "Take Snapshot";
+
             ImGui::Text("Last Snapshot: %s", last_snapshot_time_text.c_str());
             ImGui::SameLine();
             ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x
-                                 - ImGui::CalcTextSize("Take Snapshot").x
+                                 - ImGui::CalcTextSize(snapshot_button).x
                                  - ImGui::GetStyle().ItemSpacing.x);
 
-            if (ImGui::Button("Take Snapshot")) {
-                LOG(MISC, "Taking snapshot");
-                refs::take_snapshot();
-                LOG(MISC, "Snapshot finished");
-                last_snapshot_time = next_time_text_update = std::chrono::steady_clock::now();
+            if (ImGui::Button(snapshot_button)) {
+                if (taking_snapshot) {
+                    LOG(MISC, "Cancelling snapshot");
+                    refs::cancel_snapshot();
+                } else {
+                    LOG(MISC, "Taking snapshot");
+                    refs::take_snapshot(incremental_snapshot);
+                }
             }
             if (highlight_take_snapshot) {
                 ImGui::FocusItem();
@@ -217,7 +717,19 @@ void draw_search_window(void) {
                 highlight_take_snapshot = false;
             }
 
-            ImGui::TextWrapped("Taking a snapshot will freeze the game for as much as a minute.");
+            ImGui::BeginDisabled(taking_snapshot);
+            ImGui::Checkbox("Only rescan changed objects", &incremental_snapshot);
+            ImGui::EndDisabled();
+
+            draw_saved_snapshots(saved_snapshots);
+
+            if (taking_snapshot) {
+                draw_snapshot_progress(progress);
+            } else {
+                ImGui::TextWrapped(
+                    "Taking a snapshot will briefly freeze the game, the rest of the work happens "
+                    "in the background.");
+            }
 
             static const bool show_debug =
                 unrealsdk::config::get_bool("live_object_explorer.db_debug")
@@ -228,20 +740,33 @@ void draw_search_window(void) {
 #endif
             if (show_debug) {
                 ImGui::SeparatorText("Debug");
+                if (ImGui::Button("Import Snapshot")) {
+                    refs::import_snapshot();
+                    last_snapshot_time = next_time_text_update = std::chrono::steady_clock::now();
+                }
+                ImGui::SameLine();
                 if (ImGui::Button("Import DB")) {
                     refs::import_db();
                     last_snapshot_time = next_time_text_update = std::chrono::steady_clock::now();
                 }
-                ImGui::SameLine();
                 ImGui::BeginDisabled(!refs::has_snapshot());
+                if (ImGui::Button("Export Snapshot")) {
+                    refs::export_snapshot();
+                }
+                ImGui::SameLine();
                 if (ImGui::Button("Export DB")) {
                     refs::export_db();
                 }
                 ImGui::EndDisabled();
                 const uint32_t thread_min = 1;
-                const uint32_t thread_max = 32;
-                ImGui::SliderScalar("Threads", ImGuiDataType_U32, &refs::num_threads, &thread_min,
-                                    &thread_max);
+                const uint32_t thread_max = refs::MAX_THREADS;
+                // Edit a local copy, so we only ever store to the shared setting
+                uint32_t threads = refs::num_threads;
+                if (ImGui::SliderScalar("Threads", ImGuiDataType_U32, &threads, &thread_min,
+                                        &thread_max)) {
+                    refs::num_threads = threads;
+                }
+                draw_snapshot_stats();
             }
         } else {
             ImGui::GetCurrentWindow()->WindowPadding.x = old_padding;
@@ -251,52 +776,26 @@ void draw_search_window(void) {
         // Doesn't seem entirely accurate, but at least avoids the scrollbar
         auto below_listbox_height = text_size.y + (4 * ImGui::GetStyle().FramePadding.y);
 
-        if (ImGui::BeginListBox("##search_results", ImVec2{-FLT_MIN, -below_listbox_height})) {
-            for (size_t i = 0; i < search_results.size(); i++) {
-                auto& res = search_results.at(i);
-                if (!search_filter.PassFilter(res.name.c_str())) {
-                    continue;
-                }
-
-                const bool disabled = (res.flags & SearchResult::NOT_LIVE) == 0 && !res.ptr;
-                const bool is_selected = selected_search_idx == i;
-
-                // If the lookup failed, copy the disabled styling, but don't actually disable it
-                // This means you can select it again later, to check if it exists then
-                auto old_alpha = ImGui::GetStyle().Alpha;
-                if (!disabled && (res.flags & SearchResult::LOOKUP_FAILED) != 0) {
-                    ImGui::GetStyle().Alpha *= ImGui::GetStyle().DisabledAlpha;
-                }
-
-                if (ImGui::Selectable(res.name.c_str(), is_selected,
-                                      disabled ? ImGuiSelectableFlags_Disabled : 0)) {
-                    selected_search_idx = i;
+        if (!retainer_results.empty()) {
+            draw_retainers_table(ImVec2{-FLT_MIN, -below_listbox_height});
+        } else if (ImGui::BeginListBox("##search_results",
+                                       ImVec2{-FLT_MIN, -below_listbox_height})) {
+            if (refs::is_searching()) {
+                ImGui::TextDisabled("Searching...");
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Cancel")) {
+                    refs::cancel_search();
                 }
-
-                ImGui::GetStyle().Alpha = old_alpha;
-
-                if (is_selected) {
-                    ImGui::SetItemDefaultFocus();
+            }
+            for (auto& res : search_results) {
+                if (search_filter.PassFilter(res.name.c_str())) {
+                    draw_search_result(res);
                 }
-
-                if (ImGui::IsItemHovered()
-                    && (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)
-                        || ImGui::IsKeyPressed(ImGuiKey_Enter))) {
-                    if ((res.flags & SearchResult::NOT_LIVE) == 0) {
-                        if (!disabled) {
-                            open_object_window(*(res.ptr));
-                        }
-                    } else {
-                        // Allow searching for a disabled object again, in case it exists now
-                        auto obj =
-                            unrealsdk::find_object(L"Object", unrealsdk::utils::widen(res.name));
-                        if (obj == nullptr) {
-                            res.flags |= SearchResult::LOOKUP_FAILED;
-                        } else {
-                            res.flags &= ~SearchResult::LOOKUP_FAILED;
-                            open_object_window(obj);
-                        }
-                    }
+            }
+            // Filter groups by their own name, the whole point is to avoid touching their results
+            for (auto& group : search_groups) {
+                if (search_filter.PassFilter(group.name.c_str())) {
+                    draw_search_result_group(group);
                 }
             }
             ImGui::EndListBox();
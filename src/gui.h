@@ -11,9 +11,31 @@ struct SearchResult {
     // If not live, the object was selected at some point, and we couldn't find it
     static constexpr auto LOOKUP_FAILED = 1 << 1;
 
+    static constexpr auto UNKNOWN_GOBJECTS_IDX = std::numeric_limits<size_t>::max();
+
     std::string name;                              // The object path name
     unrealsdk::unreal::WeakPointer ptr = nullptr;  // A weak pointer to the object
     uint8_t flags = 0;                             // Search result flags
+    // If not live, the GObjects index the object was last seen at, to try before looking it up
+    size_t gobjects_idx = UNKNOWN_GOBJECTS_IDX;
+    std::string note{};  // Extra info shown after the name, if not empty
+};
+
+struct RetainerResult {
+    SearchResult result;
+    uint64_t shallow_size;   // How much memory the object owns directly, in bytes
+    uint64_t retained_size;  // How much memory would be freed along with the object, in bytes
+};
+
+struct SearchResultGroup {
+    std::string name;  // The name of the group
+    size_t count;      // How many results are in the group
+    // Fills in the group's results. Only called the first time it's expanded, so huge result sets
+    // never need to build every name up front.
+    std::function<void(std::vector<SearchResult>& results)> load_results;
+
+    std::vector<SearchResult> results{};
+    bool loaded = false;
 };
 
 /**
@@ -18,7 +18,14 @@
 #include <dxgi1_4.h>
 
 #ifdef __cplusplus
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <condition_variable>
 #include <list>
+#include <map>
+#include <numeric>
+#include <span>
 
 #include <imgui.h>
 #include <imgui_impl_dx11.h>
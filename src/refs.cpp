@@ -1,6 +1,20 @@
 #include "pch.h"
 #include "refs.h"
+#include "function_cache.h"
+#include "gobjects_run.h"
 #include "gui.h"
+#include "refs/cycles.h"
+#include "refs/diff.h"
+#include "refs/dominators.h"
+#include "refs/graph.h"
+#include "refs/groups.h"
+#include "refs/neighbourhood.h"
+#include "refs/parallel_for.h"
+#include "refs/path_names.h"
+#include "refs/paths.h"
+#include "refs/reachability.h"
+#include "refs/roots.h"
+#include "refs/snapshot_file.h"
 #include "refs_searcher.h"
 
 #ifdef __clang__
@@ -26,9 +40,9 @@ using namespace unrealsdk::unreal;
 
 namespace live_object_explorer::refs {
 
-// While we have the mechanisms to support multithreading, benchmarks show a single thread actually
-// performs best
-uint32_t num_threads = 1;
+// Each thread writes into its own shard, so there's no shared state to bottleneck on
+std::atomic<uint32_t> num_threads =
+    std::clamp(std::thread::hardware_concurrency(), 1U, MAX_THREADS);
 
 namespace {
 
@@ -45,7 +59,197 @@ struct RaiiLambda {
     RaiiLambda& operator=(RaiiLambda&&) = delete;
 };
 
-std::shared_ptr<sqlite3> database{};
+// The latest finished snapshot. Only ever swapped out whole, so searches can keep using their own
+// reference to the old one while a new one's being built.
+std::mutex graph_mutex{};
+std::shared_ptr<const internal::Graph> graph{};
+
+/**
+ * @brief Gets the latest finished snapshot.
+ *
+ * @return The snapshot graph, or nullptr if we don't have one.
+ */
+std::shared_ptr<const internal::Graph> get_graph(void) {
+    const std::scoped_lock lock{graph_mutex};
+    return graph;
+}
+
+/**
+ * @brief Replaces the latest snapshot.
+ *
+ * @param new_graph The new snapshot graph.
+ */
+void set_graph(std::shared_ptr<const internal::Graph>&& new_graph) {
+    const std::scoped_lock lock{graph_mutex};
+    graph = std::move(new_graph);
+}
+
+// Stats of the latest finished snapshot, swapped out in the same way
+std::shared_ptr<const SnapshotStats> snapshot_stats{};
+
+/**
+ * @brief Replaces the stats of the latest snapshot.
+ *
+ * @param new_stats The new stats.
+ */
+void set_snapshot_stats(std::shared_ptr<const SnapshotStats>&& new_stats) {
+    const std::scoped_lock lock{graph_mutex};
+    snapshot_stats = std::move(new_stats);
+}
+
+// Snapshots the user saved to diff against later, by name. Also guarded by the graph mutex.
+std::map<std::string, std::shared_ptr<const internal::Graph>, std::less<>> saved_snapshots{};
+
+/**
+ * @brief Finds a snapshot by name.
+ *
+ * @param name The name of the saved snapshot, or empty to get the current one.
+ * @return The snapshot graph, or nullptr if it doesn't exist.
+ */
+std::shared_ptr<const internal::Graph> find_snapshot(std::string_view name) {
+    if (name.empty()) {
+        return get_graph();
+    }
+    const std::scoped_lock lock{graph_mutex};
+    auto iter = saved_snapshots.find(name);
+    return iter == saved_snapshots.end() ? nullptr : iter->second;
+}
+
+/**
+ * @brief The results of the last scan we did, used to work out what's changed in the next one.
+ */
+struct ScanState {
+    std::shared_ptr<const internal::Graph> graph;
+    // Sorted by object
+    std::vector<internal::ObjectRecord> records;
+
+    /**
+     * @brief Finds an object's record from this scan, if it's still the same object.
+     *
+     * @param record The object's record from the new scan.
+     * @return The object's previous record, or nullptr if it's new.
+     */
+    [[nodiscard]] const internal::ObjectRecord* find_same_object(
+        const internal::ObjectRecord& record) const {
+        auto iter = std::ranges::lower_bound(this->records, record.obj, {},
+                                             &internal::ObjectRecord::obj);
+        // If any of these changed, the object was destroyed and something else was allocated in
+        // it's place
+        if (iter == this->records.end() || iter->obj != record.obj
+            || iter->gobjects_idx != record.gobjects_idx || iter->outer != record.outer
+            || iter->cls != record.cls || iter->name != record.name) {
+            return nullptr;
+        }
+        return &*iter;
+    }
+};
+
+// Only ever touched by the snapshot thread
+std::unique_ptr<const ScanState> last_scan{};
+
+// The background snapshot job, and it's progress. The thread is only ever started, cancelled or
+// joined from the gui thread, or on shutdown.
+std::jthread snapshot_thread{};
+std::atomic<bool> snapshot_running = false;
+std::atomic<bool> snapshot_finished = false;
+std::atomic<SnapshotProgress::Phase> snapshot_phase = SnapshotProgress::Phase::IDLE;
+std::atomic<size_t> snapshot_done = 0;
+std::atomic<size_t> snapshot_total = 0;
+std::atomic<size_t> snapshot_refs_found = 0;
+
+/**
+ * @brief The results of a search run in the background.
+ */
+struct SearchOutput {
+    std::vector<gui::SearchResult> results;
+    std::vector<gui::SearchResultGroup> groups;
+    std::vector<gui::RetainerResult> retainers;
+};
+using search_job_func =
+    std::function<void(const std::stop_token& stop_token, SearchOutput& output)>;
+
+// The background search, and it's results once finished. Used for anything which walks a large
+// chunk of the graph, so the overlay keeps drawing while it runs. Like the snapshot thread, only
+// ever started, cancelled or joined from the gui thread, or on shutdown.
+std::jthread search_thread{};
+std::atomic<bool> search_running = false;
+std::mutex finished_search_mutex;
+std::optional<SearchOutput> finished_search{};
+
+// How many of the most expensive classes to keep in the snapshot stats
+const constexpr auto NUM_TOP_CLASSES = 10;
+
+/**
+ * @brief The time taken to scan a single chunk of gobjects, gathered per thread.
+ */
+struct ChunkScanCost {
+    // One past the last record this chunk added to the thread's records
+    size_t records_end;
+    std::chrono::steady_clock::duration time;
+};
+
+/**
+ * @brief The estimated cost of scanning all objects of a single class.
+ */
+struct ClassScanCost {
+    size_t objects = 0;
+    std::chrono::steady_clock::duration time{};
+};
+using class_cost_map = std::unordered_map<uintptr_t, ClassScanCost>;
+
+#if UNREALSDK_FLAVOUR == UNREALSDK_FLAVOUR_WILLOW
+// RF_RootSet
+const constexpr uint64_t ROOT_OBJECT_FLAGS = 0x4000;
+#else
+// RF_MarkAsRootSet. The real root set flag lives in the object's internal GObjects item, which we
+// can't get at, so this only catches objects which were created straight into the root set.
+const constexpr uint64_t ROOT_OBJECT_FLAGS = 0x80;
+#endif
+
+/**
+ * @brief The classes we need to work out an object's graph flags, looked up once per snapshot.
+ */
+struct FlagClasses {
+    const UClass* field;
+    const UClass* engine;
+    const UClass* world;
+};
+
+/**
+ * @brief Works out the graph flags of an object.
+ *
+ * @param obj The object.
+ * @param classes The classes to check the object against.
+ * @return The object's flags.
+ */
+uint8_t get_graph_flags(UObject* obj, const FlagClasses& classes) {
+    uint8_t flags = 0;
+    if ((obj->ObjectFlags() & ROOT_OBJECT_FLAGS) != 0) {
+        flags |= internal::OBJECT_FLAG_ROOT;
+    }
+    if (obj->is_instance(classes.field)) {
+        flags |= internal::OBJECT_FLAG_FIELD;
+    }
+    if (obj->Class()->ClassDefaultObject() == obj) {
+        flags |= internal::OBJECT_FLAG_DEFAULT;
+    }
+    if (obj->is_instance(classes.engine) || obj->is_instance(classes.world)) {
+        flags |= internal::OBJECT_FLAG_SINGLETON;
+    }
+    return flags;
+}
+
+// The most results to show in the top retainers view
+const constexpr size_t MAX_TOP_RETAINERS = 1000;
+// The most cycles to show in the cycles view
+const constexpr size_t MAX_CYCLES = 1000;
+// How many of the most common classes to name in each cycle's description
+const constexpr size_t CYCLE_NAMED_CLASSES = 3;
+// The most objects a transitive refs search may find
+const constexpr size_t MAX_TRANSITIVE_REFS = 100000;
+
+// Bumped whenever the database schema changes, so we don't try import an incompatible one
+const constexpr auto DB_SCHEMA_VERSION = 6;
 
 /**
  * @brief Opens a new database connection.
@@ -81,467 +285,1623 @@ std::filesystem::path get_local_db_path(void) {
 }
 
 /**
- * @brief Wipes and creates a new database.
+ * @brief Gets the path to the local native snapshot file, for import/exports.
  *
- * @return True if successfully created, false on any error.
+ * @return The path to the local snapshot file.
  */
-bool create_new_db(void) {
-    database = open_db(":memory:");
+std::filesystem::path get_local_snapshot_path(void) {
+    return unrealsdk::utils::get_this_dll().parent_path() / "live_object_explorer_refs.snapshot";
+}
 
-    auto exec = [](const char* query) {
-        char* error = nullptr;
-        auto ret = sqlite3_exec(database.get(), query, nullptr, nullptr, &error);
-        if (ret != SQLITE_OK) {
-            LOG(ERROR, "Sqlite exec failed: {}", sqlite3_errstr(ret));
-            BREAKPOINT();
-            if (error != nullptr) {
-                LOG(ERROR, "{}", error);
-                sqlite3_free(error);
-            }
-            return false;
+/**
+ * @brief Executes one or more sqlite statements, which don't return anything.
+ *
+ * @param db The database to execute on.
+ * @param query The query to execute.
+ * @return True if successful, false on any error.
+ */
+bool exec(sqlite3* db, const char* query) {
+    char* error = nullptr;
+    auto ret = sqlite3_exec(db, query, nullptr, nullptr, &error);
+    if (ret != SQLITE_OK) {
+        LOG(ERROR, "Sqlite exec failed: {}", sqlite3_errstr(ret));
+        BREAKPOINT();
+        if (error != nullptr) {
+            LOG(ERROR, "{}", error);
+            sqlite3_free(error);
         }
-        return true;
-    };
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Sets up a fresh database for bulk loading a snapshot into.
+ * @note Leaves the database inside a transaction, finish it off using `finish_bulk_load`.
+ *
+ * @param db The database to set up.
+ * @return True if successfully set up, false on any error.
+ */
+bool start_bulk_load(sqlite3* db) {
+    // We only ever write the entire database in one go, if we fail part way through we'll just
+    // delete it, so there's no point paying for a journal, syncs, or checking foreign keys
+    // Pragmas can't be changed inside a transaction, so do them in a separate statement first
+    const auto pragmas = std::format(R"==(
+        PRAGMA journal_mode = OFF;
+        PRAGMA synchronous = OFF;
+        PRAGMA foreign_keys = OFF;
+        PRAGMA locking_mode = EXCLUSIVE;
+        PRAGMA temp_store = MEMORY;
+        PRAGMA user_version = {};
+    )==",
+                                     DB_SCHEMA_VERSION);
+    if (!exec(db, pragmas.c_str())) {
+        return false;
+    }
+
+    // Objects are keyed by their dense graph id, which is an alias of the rowid. We always insert
+    // in id order, so the table is only ever appended to.
+    // Refs use their (from, to) pair as the primary key directly, without a rowid, so the table
+    // itself is the forward index. They're also inserted in sorted order. The reverse and name
+    // indexes get created all at once when finished.
+    return exec(db, R"==(
+        BEGIN;
 
-    // Keep foreign_keys in a separate statement to be safe
-    return exec("PRAGMA foreign_keys = ON") && exec(R"==(
         CREATE TABLE Objects (
-            Pointer     INTEGER NOT NULL UNIQUE,
+            Id          INTEGER NOT NULL,
+            Pointer     INTEGER NOT NULL,
+            ObjectIndex INTEGER,
+            ClassId     INTEGER,
+            OuterId     INTEGER,
+            Flags       INTEGER NOT NULL,
+            ShallowSize INTEGER NOT NULL,
             Name        TEXT,
-            PRIMARY KEY(Pointer)
+            PRIMARY KEY(Id),
+            FOREIGN KEY(ClassId) REFERENCES Objects(Id),
+            FOREIGN KEY(OuterId) REFERENCES Objects(Id)
         ) STRICT;
 
         CREATE TABLE Refs (
-            FromPointer INTEGER NOT NULL,
-            ToPointer   INTEGER NOT NULL,
-            FOREIGN KEY(FromPointer) REFERENCES Objects(Pointer),
-            FOREIGN KEY(ToPointer) REFERENCES Objects(Pointer),
-            UNIQUE(FromPointer, ToPointer)
-        ) STRICT;
+            FromId      INTEGER NOT NULL,
+            ToId        INTEGER NOT NULL,
+            PRIMARY KEY(FromId, ToId),
+            FOREIGN KEY(FromId) REFERENCES Objects(Id),
+            FOREIGN KEY(ToId) REFERENCES Objects(Id)
+        ) STRICT, WITHOUT ROWID;
+    )==");
+}
+
+/**
+ * @brief Finishes bulk loading a snapshot into a database.
+ *
+ * @param db The database to finish.
+ * @return True if successfully finished, false on any error.
+ */
+bool finish_bulk_load(sqlite3* db) {
+    // Building the indexes after all the rows are in place is a single sorted pass, rather than a
+    // b-tree insert per row
+    // The reverse index covers both columns, so looking up refs to an object never has to touch
+    // the table itself
+    return exec(db, R"==(
+        CREATE INDEX RefsToFrom ON Refs(ToId, FromId);
+        CREATE INDEX ObjectsName ON Objects(Name);
+
+        COMMIT;
     )==");
 }
 
 /**
  * @brief Prepares a sqlite query.
  *
+ * @param db The database to prepare the query on.
  * @param query The query to prepare.
  * @param persistent If to mark this as a persistent query.
  * @return A pointer to the prepared statement, or null on error.
  */
-std::shared_ptr<sqlite3_stmt> prepare_statement(std::string_view query, bool persistent = true) {
+std::shared_ptr<sqlite3_stmt> prepare_statement(sqlite3* db,
+                                                std::string_view query,
+                                                bool persistent = true) {
     sqlite3_stmt* raw_statement = nullptr;
-    auto res =
-        sqlite3_prepare_v3(database.get(), query.data(), static_cast<int>(query.size() + 1),
-                           persistent ? SQLITE_PREPARE_PERSISTENT : 0, &raw_statement, nullptr);
+    auto res = sqlite3_prepare_v3(db, query.data(), static_cast<int>(query.size() + 1),
+                                  persistent ? SQLITE_PREPARE_PERSISTENT : 0, &raw_statement,
+                                  nullptr);
     if (res != SQLITE_OK) {
-        LOG(ERROR, "Failed to prepare statement: {}", sqlite3_errmsg(database.get()));
+        LOG(ERROR, "Failed to prepare statement: {}", sqlite3_errmsg(db));
         BREAKPOINT();
         return {nullptr};
     }
     return {raw_statement, sqlite3_finalize};
 };
 
-// We need one prepared statement per thread. Rather than actually deal with statements, I'd prefer
-// lambdas, with raii cleanup - so make some factory functions that return a lambda.
-
 /**
- * @brief Creates a lambda to insert an object name.
+ * @brief Binds an object id to a statement parameter, binding null if it's invalid.
  *
- * @return The lambda, or null on failure.
+ * @param statement The statement to bind to.
+ * @param idx The index of the parameter to bind.
+ * @param id The object id to bind.
+ * @param param_name The name of the parameter, to use in error messages.
+ * @return True if successfully bound, false on any error.
  */
-std::function<void(UObject*)> create_insert_object_lambda(void) {
-    auto upsert_object_statement = prepare_statement(R"==(
-        INSERT INTO
-            Objects (Pointer, Name)
-        VALUES
-            (:pointer, :name)
-        ON CONFLICT(Pointer) DO UPDATE SET
-            Name = :name
-    )==");
-
-    if (upsert_object_statement == nullptr) {
-        return nullptr;
+bool bind_object_id(sqlite3_stmt* statement,
+                    int idx,
+                    internal::object_id id,
+                    std::string_view param_name) {
+    auto res = id == internal::Graph::INVALID_ID ? sqlite3_bind_null(statement, idx)
+                                                 : sqlite3_bind_int64(statement, idx, id);
+    if (res != SQLITE_OK) {
+        LOG(ERROR, "Failed to bind '{}' in 'insert object' query: {}", param_name,
+            sqlite3_errstr(res));
+        BREAKPOINT();
+        return false;
     }
-
-    return [upsert_object_statement](UObject* obj) {
-        if (upsert_object_statement == nullptr || obj == nullptr) {
-            return;
-        }
-        sqlite3_reset(upsert_object_statement.get());
-
-        auto pointer = static_cast<sqlite_int64>(reinterpret_cast<intptr_t>(obj));
-        auto name = obj->get_path_name();
-
-        auto res = sqlite3_bind_int64(upsert_object_statement.get(), 1, pointer);
-        if (res != SQLITE_OK) {
-            LOG(ERROR, "Failed to bind 'object' in 'upsert object' query: {}", sqlite3_errstr(res));
-            BREAKPOINT();
-            return;
-        }
-
-        static_assert(sizeof(wchar_t) == sizeof(char16_t));
-        res = sqlite3_bind_text16(upsert_object_statement.get(), 2, name.c_str(),
-                                  static_cast<int>(name.size() * sizeof(wchar_t)),
-                                  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
-                                  SQLITE_TRANSIENT);
-        if (res != SQLITE_OK) {
-            LOG(ERROR, "Failed to bind 'name' in 'upsert object' query: {}", sqlite3_errstr(res));
-            BREAKPOINT();
-            return;
-        }
-
-        res = sqlite3_step(upsert_object_statement.get());
-        if (res != SQLITE_DONE) {
-            LOG(ERROR, "Failed to step 'upsert object' query: {}", sqlite3_errmsg(database.get()));
-            BREAKPOINT();
-            return;
-        }
-    };
+    return true;
 }
 
 /**
- * @brief Creates a lambda to insert an object reference.
+ * @brief Writes the contents of a graph into a database.
+ * @note Relies on the graph already being sorted and deduplicated.
  *
- * @return The lambda, or null on failure.
+ * @param db The database to write to. Must already be setup for bulk loading.
+ * @param graph_to_write The graph to write.
+ * @return True if successfully written, false on any error.
  */
-internal::refs_callback create_insert_ref_lambda(void) {
-    // We know the from object must already have been inserted, so only need to add the to object
-    auto insert_object_statement = prepare_statement(R"==(
-        INSERT OR IGNORE INTO
-            Objects (Pointer)
+bool write_graph(sqlite3* db, const internal::Graph& graph_to_write) {
+    auto insert_object_statement = prepare_statement(db, R"==(
+        INSERT INTO
+            Objects (Id, Pointer, ObjectIndex, ClassId, OuterId, Flags, ShallowSize, Name)
         VALUES
-            (:to)
-        ON CONFLICT(Pointer) DO NOTHING
+            (:id, :pointer, :object_index, :class_id, :outer_id, :flags, :shallow_size, :name)
     )==");
     if (insert_object_statement == nullptr) {
-        return nullptr;
+        return false;
     }
-    auto insert_ref_statement = prepare_statement(R"==(
+    auto insert_ref_statement = prepare_statement(db, R"==(
         INSERT INTO
-            Refs (FromPointer, ToPointer)
+            Refs (FromId, ToId)
         VALUES
             (:from, :to)
-        ON CONFLICT(FromPointer, ToPointer) DO NOTHING
     )==");
     if (insert_ref_statement == nullptr) {
-        return nullptr;
+        return false;
     }
 
-    return [insert_object_statement, insert_ref_statement](UObject* from_obj, UObject* to_obj) {
-        if (insert_object_statement == nullptr || insert_ref_statement == nullptr
-            || from_obj == nullptr || to_obj == nullptr) {
-            return;
-        }
+    for (internal::object_id id = 0; id < graph_to_write.num_objects(); id++) {
         sqlite3_reset(insert_object_statement.get());
-        sqlite3_reset(insert_ref_statement.get());
 
-        auto from_pointer = static_cast<sqlite_int64>(reinterpret_cast<intptr_t>(from_obj));
-        auto to_pointer = static_cast<sqlite_int64>(reinterpret_cast<intptr_t>(to_obj));
+        auto res = sqlite3_bind_int64(insert_object_statement.get(), 1, id);
+        if (res != SQLITE_OK) {
+            LOG(ERROR, "Failed to bind 'id' in 'insert object' query: {}", sqlite3_errstr(res));
+            BREAKPOINT();
+            return false;
+        }
 
-        auto res = sqlite3_bind_int64(insert_ref_statement.get(), 1, from_pointer);
+        res = sqlite3_bind_int64(insert_object_statement.get(), 2,
+                                 static_cast<sqlite_int64>(graph_to_write.pointer(id)));
         if (res != SQLITE_OK) {
-            LOG(ERROR, "Failed to bind 'from object' in 'insert ref' query: {}",
+            LOG(ERROR, "Failed to bind 'pointer' in 'insert object' query: {}",
                 sqlite3_errstr(res));
             BREAKPOINT();
-            return;
+            return false;
         }
 
-        res = sqlite3_bind_int64(insert_object_statement.get(), 1, to_pointer);
+        auto gobjects_idx = graph_to_write.gobjects_index(id);
+        if (gobjects_idx == internal::UNKNOWN_GOBJECTS_IDX) {
+            res = sqlite3_bind_null(insert_object_statement.get(), 3);
+        } else {
+            res = sqlite3_bind_int64(insert_object_statement.get(), 3, gobjects_idx);
+        }
         if (res != SQLITE_OK) {
-            LOG(ERROR, "Failed to bind 'to object' in 'insert object' query: {}",
+            LOG(ERROR, "Failed to bind 'object_index' in 'insert object' query: {}",
                 sqlite3_errstr(res));
             BREAKPOINT();
-            return;
+            return false;
+        }
+
+        if (!bind_object_id(insert_object_statement.get(), 4, graph_to_write.class_id(id),
+                            "class_id")
+            || !bind_object_id(insert_object_statement.get(), 5, graph_to_write.outer_id(id),
+                               "outer_id")) {
+            return false;
         }
-        res = sqlite3_bind_int64(insert_ref_statement.get(), 2, to_pointer);
+
+        res = sqlite3_bind_int64(insert_object_statement.get(), 6, graph_to_write.flags(id));
         if (res != SQLITE_OK) {
-            LOG(ERROR, "Failed to bind 'to object' in 'insert ref' query: {}", sqlite3_errstr(res));
+            LOG(ERROR, "Failed to bind 'flags' in 'insert object' query: {}", sqlite3_errstr(res));
             BREAKPOINT();
-            return;
+            return false;
         }
 
-        res = sqlite3_step(insert_object_statement.get());
-        if (res != SQLITE_DONE) {
-            LOG(ERROR, "Failed to step 'insert object' query: {}", sqlite3_errmsg(database.get()));
+        res = sqlite3_bind_int64(insert_object_statement.get(), 7,
+                                 graph_to_write.shallow_size(id));
+        if (res != SQLITE_OK) {
+            LOG(ERROR, "Failed to bind 'shallow_size' in 'insert object' query: {}",
+                sqlite3_errstr(res));
             BREAKPOINT();
-            return;
+            return false;
+        }
+
+        auto name = graph_to_write.name(id);
+        if (name.empty()) {
+            res = sqlite3_bind_null(insert_object_statement.get(), 8);
+        } else {
+            res = sqlite3_bind_text(insert_object_statement.get(), 8, name.data(),
+                                    static_cast<int>(name.size()),
+                                    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+                                    SQLITE_STATIC);
+        }
+        if (res != SQLITE_OK) {
+            LOG(ERROR, "Failed to bind 'name' in 'insert object' query: {}", sqlite3_errstr(res));
+            BREAKPOINT();
+            return false;
         }
 
-        res = sqlite3_step(insert_ref_statement.get());
+        res = sqlite3_step(insert_object_statement.get());
         if (res != SQLITE_DONE) {
-            LOG(ERROR, "Failed to step 'insert ref' query: {}", sqlite3_errmsg(database.get()));
+            LOG(ERROR, "Failed to step 'insert object' query: {}", sqlite3_errmsg(db));
             BREAKPOINT();
-            return;
+            return false;
         }
-    };
+    }
+
+    for (internal::object_id from = 0; from < graph_to_write.num_objects(); from++) {
+        for (auto to : graph_to_write.refs_from(from)) {
+            sqlite3_reset(insert_ref_statement.get());
+
+            auto res = sqlite3_bind_int64(insert_ref_statement.get(), 1, from);
+            if (res != SQLITE_OK) {
+                LOG(ERROR, "Failed to bind 'from' in 'insert ref' query: {}", sqlite3_errstr(res));
+                BREAKPOINT();
+                return false;
+            }
+            res = sqlite3_bind_int64(insert_ref_statement.get(), 2, to);
+            if (res != SQLITE_OK) {
+                LOG(ERROR, "Failed to bind 'to' in 'insert ref' query: {}", sqlite3_errstr(res));
+                BREAKPOINT();
+                return false;
+            }
+
+            res = sqlite3_step(insert_ref_statement.get());
+            if (res != SQLITE_DONE) {
+                LOG(ERROR, "Failed to step 'insert ref' query: {}", sqlite3_errmsg(db));
+                BREAKPOINT();
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
 
 /**
- * @brief Perform a simple search, using a query with one arg that only returns names.
+ * @brief Runs a query, and calls a callback on every returned row.
  *
- * @param name The object name to search for.
- * @param search_results A vector to append search results to.
+ * @param db The database to run the query on.
  * @param query_name A name for the query, to use in error messages.
  * @param query The query to run.
+ * @param callback The callback to run on each row.
+ * @return True if the query completed successfully, false on any error.
  */
-void do_search(std::string_view name,
-               std::vector<gui::SearchResult>& search_results,
-               std::string_view query_name,
-               const char* query) {
-    if (!database) {
-        return;
-    }
-    auto statement = prepare_statement(query, false);
+bool for_each_row(sqlite3* db,
+                  std::string_view query_name,
+                  const char* query,
+                  const std::function<void(sqlite3_stmt*)>& callback) {
+    auto statement = prepare_statement(db, query, false);
     if (statement == nullptr) {
-        return;
-    }
-
-    auto res = sqlite3_bind_text(statement.get(), 1, name.data(), static_cast<int>(name.size()),
-                                 // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
-                                 SQLITE_STATIC);
-    if (res != SQLITE_OK) {
-        LOG(ERROR, "Failed to bind 'name' in '{}' query: {}", query_name, sqlite3_errstr(res));
-        BREAKPOINT();
-        return;
+        return false;
     }
 
     while (true) {
-        res = sqlite3_step(statement.get());
+        auto res = sqlite3_step(statement.get());
         if (res == SQLITE_DONE) {
-            return;
+            return true;
         }
         if (res != SQLITE_ROW) {
-            LOG(ERROR, "Failed to step '{}' query: {}", query_name, sqlite3_errmsg(database.get()));
+            LOG(ERROR, "Failed to step '{}' query: {}", query_name, sqlite3_errmsg(db));
             BREAKPOINT();
-            return;
+            return false;
         }
-
-        auto output_name = reinterpret_cast<const char*>(sqlite3_column_text(statement.get(), 0));
-        search_results.emplace_back(std::string(output_name), nullptr, gui::SearchResult::NOT_LIVE);
+        callback(statement.get());
     }
 }
 
-}  // namespace
-
-bool has_snapshot(void) {
-    return database != nullptr;
+/**
+ * @brief Converts an ascii character to lowercase.
+ *
+ * @param chr The character to convert.
+ * @return The lowercase character.
+ */
+constexpr char ascii_lower(char chr) {
+    return ('A' <= chr && chr <= 'Z') ? static_cast<char>(chr - 'A' + 'a') : chr;
 }
 
-void take_snapshot(void) {
-    if (!create_new_db()) {
-        database = nullptr;
-        return;
-    }
-
-    /*
-    The rough plan for a snapshot is to:
-    1. Stop the world - we can't let the game mess with objects while we're scanning.
-    2. Iterate through every object in gobjects.
-    3. Iterate through every property on each object.
-    4. If it's an object property (or any type that references UObjects), add the pair to the
-       database.
-
-    Notably we do not recursively scan, since we'll find every referenced object at some point
-    anyway.
-
-    We also do not save references to FFields - we have no way to get back to them afterwards,
-    there's no unrealsdk::find_ffield.
+/**
+ * @brief Checks if some text matches a sql LIKE pattern.
+ * @note Follows sqlite semantics, `%` and `_` are wildcards, `\` escapes, only ascii is case
+ *       insensitive.
+ *
+ * @param pattern The pattern to match.
+ * @param text The text to check.
+ * @return True if the text matches.
+ */
+bool like_match(std::string_view pattern, std::string_view text) {
+    size_t pattern_idx = 0;
+    size_t text_idx = 0;
+
+    // Where to backtrack to on a mismatch - just after the last `%`
+    size_t wildcard_pattern_idx = std::string_view::npos;
+    size_t wildcard_text_idx = 0;
+
+    while (text_idx < text.size()) {
+        if (pattern_idx < pattern.size()) {
+            auto chr = pattern[pattern_idx];
+            if (chr == '%') {
+                wildcard_pattern_idx = ++pattern_idx;
+                wildcard_text_idx = text_idx;
+                continue;
+            }
 
-    To try reduce the total snapshot time, we split step 2 into chunks, and do each on a different
-    thread. We can easily just split based on index to parallelize these. Unfortunately, in
-    practice, sqlite only allows a single writer at a time, so benchmarks have shown this doesn't
-    really significantly change the snapshotting time.
+            const bool escaped = chr == '\\' && pattern_idx + 1 < pattern.size();
+            if (escaped) {
+                chr = pattern[pattern_idx + 1];
+            }
+            if ((!escaped && chr == '_') || ascii_lower(chr) == ascii_lower(text[text_idx])) {
+                pattern_idx += escaped ? 2 : 1;
+                text_idx++;
+                continue;
+            }
+        }
 
-    Theory for a real improvement: Maybe we can create a separate database per thread, and only
-    merge them at the end. This sounds complicated, and snapshot times aren't *that bad*, so leaving
-    it for now.
-    */
+        if (wildcard_pattern_idx == std::string_view::npos) {
+            return false;
+        }
+        pattern_idx = wildcard_pattern_idx;
+        text_idx = ++wildcard_text_idx;
+    }
 
-    // Some misc setup before we stop the world
-    std::vector<std::thread> threads{};
-    threads.reserve(num_threads);
+    while (pattern_idx < pattern.size() && pattern[pattern_idx] == '%') {
+        pattern_idx++;
+    }
+    return pattern_idx == pattern.size();
+}
 
-    auto gobjects = unrealsdk::gobjects();
+/**
+ * @brief Creates a search result for a single object.
+ *
+ * @param snapshot The snapshot the id is from.
+ * @param id The id of the object.
+ * @param name The object's name. Must not be empty.
+ * @return The search result.
+ */
+gui::SearchResult make_result(const internal::Graph& snapshot,
+                              internal::object_id id,
+                              std::string_view name) {
+    auto gobjects_idx = snapshot.gobjects_index(id);
+    return {std::string{name}, nullptr, gui::SearchResult::NOT_LIVE,
+            gobjects_idx == internal::UNKNOWN_GOBJECTS_IDX ? gui::SearchResult::UNKNOWN_GOBJECTS_IDX
+                                                           : gobjects_idx};
+}
 
-    // Stop the world.
-    const unrealsdk::utils::ThreadSuspender suspend{};
+/**
+ * @brief Appends a single object to the search results.
+ *
+ * @param snapshot The snapshot the id is from.
+ * @param id The id of the object to append.
+ * @param name The object's name. Must not be empty.
+ * @param search_results A vector to append search results to.
+ */
+void append_result(const internal::Graph& snapshot,
+                   internal::object_id id,
+                   std::string_view name,
+                   std::vector<gui::SearchResult>& search_results) {
+    search_results.push_back(make_result(snapshot, id, name));
+}
 
-    auto num_objects = gobjects.size();
-    // Round up to make sure we don't miss anything, the last thread will do less
-    auto objects_per_thread = ((num_objects - 1) / num_threads) + 1;
+/**
+ * @brief Appends the names of all the given objects to the search results.
+ *
+ * @param snapshot The snapshot the ids are from.
+ * @param ids The ids of the objects to append.
+ * @param search_results A vector to append search results to.
+ */
+void append_results(const internal::Graph& snapshot,
+                    std::span<const internal::object_id> ids,
+                    std::vector<gui::SearchResult>& search_results) {
+    for (auto id : ids) {
+        auto name = snapshot.name(id);
+        if (name.empty()) {
+            continue;
+        }
+        append_result(snapshot, id, name, search_results);
+    }
+}
 
-    for (size_t start_idx = 0; start_idx < num_objects; start_idx += objects_per_thread) {
-        auto end_idx = std::min(start_idx + objects_per_thread, num_objects);
-        threads.emplace_back([start_idx, end_idx, &gobjects]() {
-            // Need to create a separate prepared statement/lambda on each thread
-            auto insert_object = create_insert_object_lambda();
-            if (insert_object == nullptr) {
-                return;
-            }
-            auto insert_ref = create_insert_ref_lambda();
-            if (insert_ref == nullptr) {
-                return;
-            }
+using get_ids_func =
+    std::function<std::span<const internal::object_id>(const internal::Graph& snapshot)>;
+using get_note_func = std::function<std::string(internal::object_id id)>;
 
-            // Iterate through all objects
-            for (auto i = start_idx; i < end_idx; i++) {
-                UObject* obj = nullptr;
-                try {
-                    obj = gobjects.obj_at(i);
-                } catch (const std::out_of_range&) {
-                    continue;
+/**
+ * @brief Appends a set of objects to the search results, as groups which are lazily filled in.
+ *
+ * @param snapshot The snapshot the ids are from.
+ * @param ids The ids of the objects to group.
+ * @param kind What to group by.
+ * @param get_ids Gets the same ids again, when a group gets expanded.
+ * @param name_prefix A prefix to add to each group's name.
+ * @param get_note Gets the note to show on each result. May be null.
+ * @param search_groups A vector to append search result groups to.
+ */
+void append_groups(const std::shared_ptr<const internal::Graph>& snapshot,
+                   std::span<const internal::object_id> ids,
+                   internal::GroupKind kind,
+                   const get_ids_func& get_ids,
+                   std::string_view name_prefix,
+                   const get_note_func& get_note,
+                   std::vector<gui::SearchResultGroup>& search_groups) {
+    for (const auto& group : internal::group_objects(*snapshot, ids, kind)) {
+        auto name = group.key == internal::Graph::INVALID_ID ? std::string_view{}
+                                                             : snapshot->name(group.key);
+
+        // Only hold a weak reference, so old results don't keep a replaced snapshot alive
+        search_groups.push_back({
+            .name = std::format("{}{}", name_prefix, name.empty() ? "Unknown" : name),
+            .count = group.count,
+            .load_results = [weak_snapshot = std::weak_ptr{snapshot}, get_ids, get_note, kind,
+                             key = group.key](std::vector<gui::SearchResult>& results) {
+                auto snapshot = weak_snapshot.lock();
+                if (snapshot == nullptr) {
+                    return;
                 }
-                if (obj == nullptr) {
-                    continue;
+                for (auto id : get_ids(*snapshot)) {
+                    auto name = snapshot->name(id);
+                    if (!name.empty() && internal::group_key(*snapshot, id, kind) == key) {
+                        append_result(*snapshot, id, name, results);
+                        if (get_note != nullptr) {
+                            results.back().note = get_note(id);
+                        }
+                    }
                 }
-
-                insert_object(obj);
-                internal::search_for_refs(obj, insert_ref);
-            }
+            },
         });
     }
-    for (auto& thread : threads) {
-        thread.join();
-    }
-}
-
-void search_names(std::string_view name, std::vector<gui::SearchResult>& search_results) {
-    do_search(name, search_results, "search names", R"==(
-        SELECT DISTINCT
-            Name
-        FROM
-            Objects
-        WHERE
-            Name like ('%' || ? || '%') ESCAPE '\'
-    )==");
 }
 
-void search_refs_to(std::string_view name, std::vector<gui::SearchResult>& search_results) {
-    do_search(name, search_results, "search refs to", R"==(
-        SELECT DISTINCT
-            Name
-        FROM
-            Objects, Refs
-        WHERE
-            Pointer = FromPointer
-            and ToPointer = (
-                SELECT
-                    Pointer
-                FROM
-                    Objects
-                WHERE
-                    Name = ?
-            )
-    )==");
+/**
+ * @brief Converts a public group by setting into it's internal equivalent.
+ *
+ * @param group_by The setting to convert.
+ * @return The group kind.
+ */
+internal::GroupKind get_group_kind(GroupBy group_by) {
+    return group_by == GroupBy::PACKAGE ? internal::GroupKind::PACKAGE
+                                        : internal::GroupKind::CLASS;
 }
 
-void search_refs_from(std::string_view name, std::vector<gui::SearchResult>& search_results) {
-    do_search(name, search_results, "search refs from", R"==(
-        SELECT DISTINCT
-            Name
-        FROM
-            Objects, Refs
-        WHERE
-            Pointer = ToPointer
-            and FromPointer = (
-                SELECT
-                    Pointer
-                FROM
-                    Objects
-                WHERE
-                    Name = ?
-            )
-    )==");
+/**
+ * @brief Finds all classes whose name matches a filter.
+ *
+ * @param snapshot The snapshot to search.
+ * @param filter A sql LIKE pattern, matched against both the class's full name and it's last part.
+ * @return The matching classes' ids, sorted.
+ */
+std::vector<internal::object_id> find_matching_classes(const internal::Graph& snapshot,
+                                                       std::string_view filter) {
+    std::vector<internal::object_id> classes{};
+    for (internal::object_id id = 0; id < snapshot.num_objects(); id++) {
+        auto class_id = snapshot.class_id(id);
+        if (class_id != internal::Graph::INVALID_ID) {
+            classes.push_back(class_id);
+        }
+    }
+    std::ranges::sort(classes);
+    auto [first, last] = std::ranges::unique(classes);
+    classes.erase(first, last);
+
+    std::erase_if(classes, [&snapshot, filter](internal::object_id id) {
+        auto name = snapshot.name(id);
+        auto short_name = name.substr(name.find_last_of('.') + 1);
+        return !like_match(filter, name) && !like_match(filter, short_name);
+    });
+    return classes;
 }
 
-void import_db(void) {
-    if (!std::filesystem::exists(get_local_db_path())) {
+/**
+ * @brief Searches for all objects within a number of refs of the given object, grouped by distance.
+ *
+ * @param name The object name to search for.
+ * @param direction Which way to follow refs.
+ * @param max_depth The most refs to follow.
+ * @param class_filter If not empty, a sql LIKE pattern for the classes of objects to report.
+ * @param search_groups A vector to append search result groups to.
+ * @param stop_token A stop token, to cancel the search early.
+ */
+void run_search_refs_within(std::string_view name,
+                            RefDirection direction,
+                            size_t max_depth,
+                            std::string_view class_filter,
+                            std::vector<gui::SearchResultGroup>& search_groups,
+                            const std::stop_token& stop_token) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+    auto id = snapshot->find_name(name);
+    if (id == internal::Graph::INVALID_ID) {
         return;
     }
 
-    // If we don't already have a db, create a new one
-    bool wipe_db_on_exit = false;
-    if (database == nullptr) {
-        wipe_db_on_exit = true;
-        database = open_db(":memory:");
-        if (database == nullptr) {
+    std::vector<internal::object_id> classes{};
+    if (!class_filter.empty()) {
+        classes = find_matching_classes(*snapshot, class_filter);
+        if (classes.empty()) {
             return;
         }
     }
-    // If we made a new db, and we get an error, then delete it
-    const RaiiLambda raii1{[&]() {
-        if (wipe_db_on_exit) {
-            database = nullptr;
+
+    auto found = std::make_shared<const internal::Neighbourhood>(internal::find_neighbourhood(
+        *snapshot, id,
+        direction == RefDirection::TO ? internal::RefDirection::TO : internal::RefDirection::FROM,
+        std::clamp<size_t>(max_depth, 1, MAX_REF_DEPTH), classes, MAX_TRANSITIVE_REFS,
+        stop_token));
+
+    for (size_t depth = 1; depth <= found->max_depth(); depth++) {
+        auto ids = found->at_depth(depth);
+        if (ids.empty()) {
+            continue;
+        }
+
+        const bool stopped_early = found->truncated && depth == found->max_depth();
+        // Only hold a weak reference, so old results don't keep a replaced snapshot alive
+        search_groups.push_back({
+            .name = std::format("Depth {}{}", depth, stopped_early ? " (stopped early)" : ""),
+            .count = ids.size(),
+            .load_results = [weak_snapshot = std::weak_ptr{snapshot}, found,
+                             depth](std::vector<gui::SearchResult>& results) {
+                auto snapshot = weak_snapshot.lock();
+                if (snapshot == nullptr) {
+                    return;
+                }
+                append_results(*snapshot, found->at_depth(depth), results);
+            },
+        });
+    }
+}
+
+/**
+ * @brief Finds the live object a snapshot id refers to.
+ *
+ * @param snapshot The snapshot the id is from.
+ * @param id The object's id.
+ * @return The object, or nullptr if it's no longer in the same GObjects slot.
+ */
+UObject* find_live_object(const internal::Graph& snapshot, internal::object_id id) {
+    auto gobjects_idx = snapshot.gobjects_index(id);
+    if (gobjects_idx == internal::UNKNOWN_GOBJECTS_IDX
+        || gobjects_idx >= unrealsdk::gobjects().size()) {
+        return nullptr;
+    }
+    auto obj = unrealsdk::gobjects().obj_at(gobjects_idx);
+    if (reinterpret_cast<uintptr_t>(obj) != snapshot.pointer(id)) {
+        return nullptr;
+    }
+    return obj;
+}
+
+/**
+ * @brief Gets the roots to start a path search from.
+ *
+ * @param snapshot The snapshot to search.
+ * @param root_set Which objects to use.
+ * @param root_name If using a single root object, it's name.
+ * @return The roots' ids.
+ */
+std::vector<internal::object_id> get_path_roots(const internal::Graph& snapshot,
+                                                RootSet root_set,
+                                                std::string_view root_name) {
+    switch (root_set) {
+        case RootSet::FLAGGED:
+            return internal::find_roots(snapshot, internal::RootKind::FLAGGED);
+        case RootSet::SINGLETONS:
+            return internal::find_roots(snapshot, internal::RootKind::SINGLETONS);
+        case RootSet::OBJECT: {
+            auto id = snapshot.find_name(root_name);
+            if (id == internal::Graph::INVALID_ID) {
+                return {};
+            }
+            return {id};
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief Finds the objects which keep the most memory alive.
+ *
+ * @param root_set Which objects to treat as roots.
+ * @param root_name If using a single root object, it's name.
+ * @param retainer_results A vector to append results to, largest retained size first.
+ * @param stop_token A stop token, to cancel the search early.
+ */
+void run_find_top_retainers(RootSet root_set,
+                            std::string_view root_name,
+                            std::vector<gui::RetainerResult>& retainer_results,
+                            const std::stop_token& stop_token) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+
+    auto roots = get_path_roots(*snapshot, root_set, root_name);
+    auto dominators = internal::build_dominator_tree(*snapshot, roots, stop_token);
+    if (stop_token.stop_requested()) {
+        return;
+    }
+
+    std::vector<internal::object_id> ids{};
+    for (internal::object_id id = 0; id < snapshot->num_objects(); id++) {
+        if (dominators.idoms[id] != internal::Graph::INVALID_ID) {
+            ids.push_back(id);
+        }
+    }
+    auto num_results = std::min(ids.size(), MAX_TOP_RETAINERS);
+    std::ranges::partial_sort(ids, ids.begin() + static_cast<ptrdiff_t>(num_results),
+                              std::ranges::greater{},
+                              [&dominators](internal::object_id id) {
+                                  return dominators.retained_sizes[id];
+                              });
+
+    for (auto id : std::span{ids}.first(num_results)) {
+        auto name = snapshot->name(id);
+        retainer_results.push_back({
+            .result = make_result(*snapshot, id, name.empty() ? "Unknown" : name),
+            .shallow_size = snapshot->shallow_size(id),
+            .retained_size = dominators.retained_sizes[id],
+        });
+    }
+}
+
+/**
+ * @brief Finds all reference cycles in the current snapshot, one group per cycle.
+ *
+ * @param include_native_refs If false, ignores refs from native fields.
+ * @param search_groups A vector to append search result groups to.
+ * @param stop_token A stop token, to cancel the search early.
+ */
+void run_find_cycles(bool include_native_refs,
+                     std::vector<gui::SearchResultGroup>& search_groups,
+                     const std::stop_token& stop_token) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+
+    auto cycles = std::make_shared<const internal::Components>(
+        internal::find_cycles(*snapshot, include_native_refs, stop_token));
+
+    for (size_t idx = 0; idx < std::min(cycles->size(), MAX_CYCLES); idx++) {
+        auto members = (*cycles)[idx];
+        auto classes = internal::group_objects(*snapshot, members, internal::GroupKind::CLASS);
+
+        std::string name = std::format("{} objects:", members.size());
+        for (size_t class_idx = 0; class_idx < std::min(classes.size(), CYCLE_NAMED_CLASSES);
+             class_idx++) {
+            const auto& [key, count] = classes[class_idx];
+            auto class_name =
+                key == internal::Graph::INVALID_ID ? std::string_view{} : snapshot->name(key);
+            name += std::format("{} {} {}", class_idx == 0 ? "" : ",", count,
+                                class_name.empty() ? "Unknown" : class_name);
+        }
+        if (classes.size() > CYCLE_NAMED_CLASSES) {
+            name += ", ...";
+        }
+
+        // Only hold a weak reference, so old results don't keep a replaced snapshot alive
+        search_groups.push_back({
+            .name = std::move(name),
+            .count = members.size(),
+            .load_results = [weak_snapshot = std::weak_ptr{snapshot}, cycles,
+                             idx](std::vector<gui::SearchResult>& results) {
+                auto snapshot = weak_snapshot.lock();
+                if (snapshot == nullptr) {
+                    return;
+                }
+                append_results(*snapshot, (*cycles)[idx], results);
+            },
+        });
+    }
+}
+
+/**
+ * @brief Finds all objects which can't be reached from anything the garbage collector keeps alive.
+ *
+ * @param group_by What to group results by, or an empty optional for a flat list.
+ * @param thread_count How many threads to use. The worker pool must already have been reserved.
+ * @param output The output to append results or groups to.
+ * @param stop_token A stop token, to cancel the search early.
+ */
+void run_find_unreachable(std::optional<GroupBy> group_by,
+                          size_t thread_count,
+                          SearchOutput& output,
+                          const std::stop_token& stop_token) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+
+    auto roots = internal::find_roots(*snapshot, internal::RootKind::ALWAYS_ALIVE);
+    auto unreachable = std::make_shared<const std::vector<internal::object_id>>(
+        internal::find_unreachable(*snapshot, roots, thread_count, stop_token));
+    if (stop_token.stop_requested()) {
+        return;
+    }
+
+    if (!group_by.has_value()) {
+        append_results(*snapshot, *unreachable, output.results);
+        return;
+    }
+    append_groups(snapshot, *unreachable, get_group_kind(*group_by),
+                  [unreachable](const internal::Graph& /*snapshot*/) {
+                      return std::span<const internal::object_id>{*unreachable};
+                  },
+                  "", nullptr, output.groups);
+}
+
+/**
+ * @brief Works out which objects were added, removed, or had their refs changed between two
+ *        snapshots, grouped by class.
+ *
+ * @param before The earlier snapshot. May be null.
+ * @param after The later snapshot. May be null.
+ * @param search_groups A vector to append search result groups to.
+ * @param stop_token A stop token, to cancel the diff early.
+ */
+void run_diff_snapshots(const std::shared_ptr<const internal::Graph>& before,
+                        const std::shared_ptr<const internal::Graph>& after,
+                        std::vector<gui::SearchResultGroup>& search_groups,
+                        const std::stop_token& stop_token) {
+    if (before == nullptr || after == nullptr) {
+        return;
+    }
+
+    auto diff = std::make_shared<const internal::SnapshotDiff>(
+        internal::diff_graphs(*before, *after, stop_token));
+    if (stop_token.stop_requested()) {
+        return;
+    }
+    auto changed_ids = std::make_shared<std::vector<internal::object_id>>();
+    changed_ids->reserve(diff->changed.size());
+    for (const auto& changed : diff->changed) {
+        changed_ids->push_back(changed.after_id);
+    }
+
+    // The groups only hold weak references to the snapshots, but they need to keep the diff alive
+    append_groups(after, diff->added, internal::GroupKind::CLASS,
+                  [diff](const internal::Graph& /*snapshot*/) {
+                      return std::span<const internal::object_id>{diff->added};
+                  },
+                  "Added: ", nullptr, search_groups);
+    append_groups(before, diff->removed, internal::GroupKind::CLASS,
+                  [diff](const internal::Graph& /*snapshot*/) {
+                      return std::span<const internal::object_id>{diff->removed};
+                  },
+                  "Removed: ", nullptr, search_groups);
+    append_groups(
+        after, *changed_ids, internal::GroupKind::CLASS,
+        [changed_ids](const internal::Graph& /*snapshot*/) {
+            return std::span<const internal::object_id>{*changed_ids};
+        },
+        "Changed: ",
+        [diff](internal::object_id id) {
+            auto changed = std::ranges::lower_bound(diff->changed, id, {},
+                                                    &internal::ChangedObject::after_id);
+            return std::format("+{} / -{} refs", changed->refs_added, changed->refs_removed);
+        },
+        search_groups);
+}
+
+/**
+ * @brief Attributes the time taken by each chunk to the classes of the objects it scanned.
+ * @note We only time whole chunks, to keep clock reads out of the per object loop during the
+ *       pause, so each object gets an even share of it's chunk's time.
+ *
+ * @param class_costs The class costs to add to.
+ * @param records The records gathered by a single thread, in the order it scanned them.
+ * @param chunk_costs The time the same thread took on each of it's chunks.
+ */
+void add_class_costs(class_cost_map& class_costs,
+                     const std::vector<internal::ObjectRecord>& records,
+                     const std::vector<ChunkScanCost>& chunk_costs) {
+    using rep = std::chrono::steady_clock::duration::rep;
+
+    size_t start_idx = 0;
+    for (const auto& chunk : chunk_costs) {
+        if (chunk.records_end > start_idx) {
+            auto time_per_object = chunk.time / static_cast<rep>(chunk.records_end - start_idx);
+            for (auto i = start_idx; i < chunk.records_end; i++) {
+                auto& cost = class_costs[records[i].cls];
+                cost.objects++;
+                cost.time += time_per_object;
+            }
+        }
+        start_idx = chunk.records_end;
+    }
+}
+
+/**
+ * @brief Fills in the most expensive classes in a snapshot's stats.
+ *
+ * @param stats The stats to fill in.
+ * @param snapshot The finished snapshot, to look up class names in.
+ * @param class_costs The cost of each class.
+ */
+void fill_top_classes(SnapshotStats& stats,
+                      const internal::Graph& snapshot,
+                      const class_cost_map& class_costs) {
+    std::vector<std::pair<uintptr_t, ClassScanCost>> sorted_costs{class_costs.begin(),
+                                                                  class_costs.end()};
+    auto num_top = std::min<size_t>(sorted_costs.size(), NUM_TOP_CLASSES);
+    std::ranges::partial_sort(sorted_costs, sorted_costs.begin() + static_cast<ptrdiff_t>(num_top),
+                              std::greater{}, [](const auto& pair) { return pair.second.time; });
+
+    for (size_t i = 0; i < num_top; i++) {
+        const auto& [cls, cost] = sorted_costs[i];
+        auto id = snapshot.find_pointer(cls);
+        stats.top_classes.push_back({
+            .name = id == internal::Graph::INVALID_ID ? std::string{}
+                                                      : std::string{snapshot.name(id)},
+            .objects = cost.objects,
+            .time = cost.time,
+        });
+    }
+}
+
+/**
+ * @brief Writes a snapshot's stats to the log.
+ *
+ * @param stats The stats to log.
+ */
+void log_snapshot_stats(const SnapshotStats& stats) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    using std::chrono::milliseconds;
+
+    LOG(MISC, "Snapshot stats ({}, {} threads):", stats.incremental ? "incremental" : "full",
+        stats.threads);
+    LOG(MISC, "Suspended for {}, scanned {} of {} objects",
+        duration_cast<milliseconds>(stats.suspended), stats.objects_rescanned, stats.objects);
+    LOG(MISC, "Naming took {}, building the graph took {}",
+        duration_cast<milliseconds>(stats.naming), duration_cast<milliseconds>(stats.building));
+    LOG(MISC, "Found {} refs, kept {}, using {} bytes", stats.refs_found, stats.refs_kept,
+        stats.memory_usage);
+    for (const auto& cls : stats.top_classes) {
+        LOG(MISC, "{} - {} objects, {}", cls.name, cls.objects,
+            duration_cast<microseconds>(cls.time));
+    }
+}
+
+/**
+ * @brief Takes a new refs snapshot. Run on the background snapshot thread.
+ *
+ * @param stop_token Stop token used to cancel the snapshot.
+ * @param incremental True if to only rescan objects which changed since the last scan.
+ * @param thread_count How many threads to use. The worker pool must already have been reserved.
+ */
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void run_snapshot(const std::stop_token& stop_token, bool incremental, size_t thread_count) {
+    /*
+    The rough plan for a snapshot is to:
+    1. Stop the world - we can't let the game mess with objects while we're scanning.
+    2. Iterate through every object in gobjects.
+    3. Iterate through every property on each object which may hold a reference. Each class's
+       properties are compiled into a flat list of offsets the first time we see it.
+    4. If the property holds a reference, add the pair to the current thread's list.
+    5. Record the raw fields we need to work out each object's name later.
+    6. Resume the world.
+    7. Build all the object names, and build all the lists into a single graph.
+
+    Notably we do not recursively scan, since we'll find every referenced object at some point
+    anyway.
+
+    We also do not save references to FFields - we have no way to get back to them afterwards,
+    there's no unrealsdk::find_ffield.
+
+    The pause is what players actually notice, so we try do as little as possible while the world
+    is stopped. Steps 3 and 4 are just reading pointers out of the object at precompiled offsets,
+    the only real work is following weak pointers and delegates, which we need to do while their
+    targets are guaranteed to still exist. The slow part used to be building path names, which is
+    why step 5 only copies the object's outer, class, and name - the names themselves are built
+    in step 7, from those copies, after the game's been allowed to run again. Since most objects
+    share their outers, each thread only builds each outer's path once, and then just appends.
+
+    To try reduce the total snapshot time, we split steps 2 and 7 into small chunks by index, which
+    a pool of threads pull from until there are none left. Since some objects are far more
+    expensive than others, this keeps every thread busy until the very end, instead of waiting on
+    whichever got the most expensive range. Each thread only ever appends to it's own shard, so
+    the only thing they share is the chunk cursor. Within a chunk, the valid objects are gathered
+    into a single run first, so we only check bounds once, and can prefetch the next few objects
+    while working on the current one.
+
+    This all runs on a background thread, so the overlay keeps drawing (outside of the pause), and
+    so searches can keep using the last snapshot until we swap in the new one at the very end.
+
+    In an incremental snapshot, during step 3, if the object's still in the same gobjects slot with
+    the same identity as in the last scan, we first hash everything it might hold a ref through. If
+    the hash is also the same, it can't have any new refs, so we skip searching it, and instead copy
+    it's refs over from the last graph when building the new one. This also lets us skip sorting
+    the vast majority of refs again. Every search hashes the slots it reads as it goes, so a full
+    snapshot still records hashes for the next one to be incremental, without walking twice.
+    */
+
+    // Some misc setup before we stop the world
+    clear_function_cache();
+    std::vector<internal::GraphShard> shards(thread_count);
+    std::vector<std::vector<internal::ObjectRecord>> thread_records(thread_count);
+    std::vector<std::vector<ChunkScanCost>> thread_chunk_costs(thread_count);
+    const ScanState* previous = incremental ? last_scan.get() : nullptr;
+
+    auto stats = std::make_shared<SnapshotStats>();
+    stats->threads = static_cast<uint32_t>(thread_count);
+    stats->incremental = previous != nullptr;
+
+    auto gobjects = unrealsdk::gobjects();
+    auto package_class = reinterpret_cast<uintptr_t>(find_class(L"Package"_fn));
+    const FlagClasses flag_classes{
+        .field = find_class<UField>(),
+        .engine = find_class(L"Engine"_fn),
+        .world = find_class(L"World"_fn),
+    };
+
+    auto phase_start = std::chrono::steady_clock::now();
+    {
+        // Stop the world.
+        const unrealsdk::utils::ThreadSuspender suspend{};
+
+        snapshot_total = gobjects.size();
+        snapshot_phase = SnapshotProgress::Phase::SCANNING;
+
+        auto scan_objects = [&shards, &thread_records, &thread_chunk_costs, &stop_token, previous,
+                             &flag_classes](size_t thread_idx, internal::ChunkCursor& cursor) {
+            auto& shard = shards[thread_idx];
+            auto& records = thread_records[thread_idx];
+            auto& chunk_costs = thread_chunk_costs[thread_idx];
+
+            internal::EdgeBuffer add_ref{};
+            internal::RefLayoutCache layouts{};
+            GObjectsRun run{};
+
+            size_t start_idx = 0;
+            size_t end_idx = 0;
+            while (!stop_token.stop_requested() && cursor.next(start_idx, end_idx)) {
+                auto refs_before = add_ref.edges.size();
+                run.gather(start_idx, end_idx);
+
+                // Only time whole chunks, we work out the per class costs after the pause
+                auto chunk_start = std::chrono::steady_clock::now();
+
+                run.for_each([&](const GObjectsRun::Entry& entry) {
+                    auto obj = entry.obj;
+                    internal::ObjectRecord record{
+                        .obj = reinterpret_cast<uintptr_t>(obj),
+                        .outer = reinterpret_cast<uintptr_t>(obj->Outer()),
+                        .cls = reinterpret_cast<uintptr_t>(obj->Class()),
+                        .name = obj->Name(),
+                        .gobjects_idx = entry.idx,
+                        .refs_hash = 0,
+                        .flags = get_graph_flags(obj, flag_classes),
+                        .shallow_size = internal::shallow_size(obj, layouts)};
+
+                    // Only objects we've seen before are worth hashing on their own - anything
+                    // else is always searched, which hashes it at the same time
+                    const auto* previous_record =
+                        previous == nullptr ? nullptr : previous->find_same_object(record);
+                    if (previous_record != nullptr) {
+                        record.refs_hash = internal::hash_refs(obj, layouts);
+                    }
+                    if (previous_record != nullptr
+                        && previous_record->refs_hash == record.refs_hash) {
+                        shard.unchanged_objects.push_back(record.obj);
+                    } else {
+                        record.refs_hash = internal::search_and_hash_refs(obj, layouts, add_ref);
+                    }
+                    records.push_back(record);
+                });
+                chunk_costs.push_back({.records_end = records.size(),
+                                       .time = std::chrono::steady_clock::now() - chunk_start});
+
+                // Only publish progress once per chunk, to avoid fighting over the counters
+                snapshot_done += end_idx - start_idx;
+                snapshot_refs_found += add_ref.edges.size() - refs_before;
+            }
+            shard.refs = std::move(add_ref.edges);
+        };
+        internal::parallel_for(gobjects.size(), thread_count, scan_objects);
+    }
+    auto phase_end = std::chrono::steady_clock::now();
+    stats->suspended = phase_end - phase_start;
+    phase_start = phase_end;
+
+    if (stop_token.stop_requested()) {
+        return;
+    }
+
+    // The game can keep running while we build the names and the graph. Work out the class costs
+    // first, while we still know which chunk each record came from.
+    class_cost_map class_costs{};
+    for (size_t i = 0; i < thread_count; i++) {
+        add_class_costs(class_costs, thread_records[i], thread_chunk_costs[i]);
+    }
+    thread_chunk_costs = {};
+
+    std::vector<internal::ObjectRecord> records{};
+    records.reserve(std::transform_reduce(thread_records.begin(), thread_records.end(), size_t{0},
+                                          std::plus{}, [](auto& vec) { return vec.size(); }));
+    for (auto& vec : thread_records) {
+        records.insert(records.end(), vec.begin(), vec.end());
+        vec = {};
+    }
+    std::ranges::sort(records, {}, &internal::ObjectRecord::obj);
+
+    snapshot_done = 0;
+    snapshot_total = records.size();
+    snapshot_phase = SnapshotProgress::Phase::NAMING;
+
+    auto name_objects = [&shards, &records, package_class, &stop_token](
+                            size_t thread_idx, internal::ChunkCursor& cursor) {
+        auto& shard = shards[thread_idx];
+        internal::PathNameBuilder builder{records, package_class};
+
+        size_t start_idx = 0;
+        size_t end_idx = 0;
+        while (!stop_token.stop_requested() && cursor.next(start_idx, end_idx)) {
+            for (auto i = start_idx; i < end_idx; i++) {
+                builder.add_object(i, shard);
+            }
+            snapshot_done += end_idx - start_idx;
+        }
+    };
+    internal::parallel_for(records.size(), thread_count, name_objects);
+
+    if (stop_token.stop_requested()) {
+        return;
+    }
+    snapshot_phase = SnapshotProgress::Phase::BUILDING;
+
+    phase_end = std::chrono::steady_clock::now();
+    stats->naming = phase_end - phase_start;
+    phase_start = phase_end;
+
+    auto num_unchanged =
+        std::transform_reduce(shards.begin(), shards.end(), size_t{0}, std::plus{},
+                              [](auto& shard) { return shard.unchanged_objects.size(); });
+    stats->objects = records.size();
+    stats->objects_rescanned = records.size() - num_unchanged;
+    stats->refs_found = std::transform_reduce(shards.begin(), shards.end(), size_t{0}, std::plus{},
+                                              [](auto& shard) { return shard.refs.size(); });
+
+    auto new_graph = std::make_shared<const internal::Graph>(
+        std::move(shards), thread_count, previous == nullptr ? nullptr : previous->graph.get());
+
+    stats->building = std::chrono::steady_clock::now() - phase_start;
+    stats->refs_kept = new_graph->num_refs();
+    stats->memory_usage = new_graph->memory_usage();
+    fill_top_classes(*stats, *new_graph, class_costs);
+    log_snapshot_stats(*stats);
+
+    last_scan = std::make_unique<const ScanState>(new_graph, std::move(records));
+    set_graph(std::move(new_graph));
+    set_snapshot_stats(std::move(stats));
+    snapshot_finished = true;
+}
+
+/**
+ * @brief Stops one of our background threads, before the dll gets unloaded.
+ *
+ * @param thread The thread to stop.
+ * @param running The flag the thread clears once it's done running our code.
+ * @param process_exiting True if the whole process is exiting.
+ */
+void stop_background_thread(std::jthread& thread,
+                            std::atomic<bool>& running,
+                            bool process_exiting) {
+    if (!thread.joinable()) {
+        return;
+    }
+    thread.request_stop();
+
+    // If the process is exiting, the thread's already been terminated. Otherwise, wait for it to
+    // finish running our code. We can't actually join it, since we're called under the loader
+    // lock, which the thread needs in order to exit - but after it clears the running flag it
+    // doesn't touch anything else of ours.
+    // Waiting is only safe since background jobs never start or join threads themselves - they
+    // only hand work to the worker pool, whose threads were all started beforehand, from the gui
+    // thread, and never exit. Anything the pool can't pick up, the job runs itself.
+    if (!process_exiting) {
+        running.wait(true);
+    }
+    thread.detach();
+}
+
+/**
+ * @brief Starts running a search on the background search thread.
+ * @note Cancels any search which was already running, and discards it's results.
+ *
+ * @param job The search to run.
+ */
+void start_search(search_job_func&& job) {
+    // Wait for any previous search to stop, so it can't publish it's results over ours
+    if (search_thread.joinable()) {
+        search_thread.request_stop();
+        search_thread.join();
+    }
+    {
+        const std::scoped_lock lock{finished_search_mutex};
+        finished_search.reset();
+    }
+
+    search_running = true;
+    search_thread = std::jthread{[job = std::move(job)](const std::stop_token& stop_token) {
+        SearchOutput output{};
+        try {
+            job(stop_token, output);
+        } catch (const std::exception& ex) {
+            LOG(ERROR, "Search failed: {}", ex.what());
+        }
+
+        {
+            // Cancelling requests a stop before taking the lock, so checking under it means we
+            // can't publish after a cancel has already cleared the results
+            const std::scoped_lock lock{finished_search_mutex};
+            if (!stop_token.stop_requested()) {
+                finished_search = std::move(output);
+            }
+        }
+        search_running = false;
+        search_running.notify_all();
+    }};
+}
+
+}  // namespace
+
+bool has_snapshot(void) {
+    return get_graph() != nullptr;
+}
+
+void take_snapshot(bool incremental) {
+    if (snapshot_running.exchange(true)) {
+        return;
+    }
+
+    snapshot_done = 0;
+    snapshot_total = 0;
+    snapshot_refs_found = 0;
+    snapshot_phase = SnapshotProgress::Phase::SCANNING;
+
+    // The setting may be changed while we're running, so make sure to only read it once. Start any
+    // workers we need from here, so the snapshot thread never has to start threads itself.
+    const size_t thread_count = num_threads.load();
+    internal::reserve_workers(thread_count);
+
+    // If there's a previous thread, it's already finished, so replacing it joins immediately
+    snapshot_thread = std::jthread{[incremental, thread_count](const std::stop_token& stop_token) {
+        try {
+            run_snapshot(stop_token, incremental, thread_count);
+        } catch (const std::exception& ex) {
+            LOG(ERROR, "Snapshot failed: {}", ex.what());
         }
+        if (stop_token.stop_requested()) {
+            LOG(MISC, "Snapshot cancelled");
+        }
+        snapshot_phase = SnapshotProgress::Phase::IDLE;
+        snapshot_running = false;
+        snapshot_running.notify_all();
     }};
+}
+
+void cancel_snapshot(void) {
+    snapshot_thread.request_stop();
+}
+
+SnapshotProgress get_snapshot_progress(void) {
+    return {.phase = snapshot_phase,
+            .done = snapshot_done,
+            .total = snapshot_total,
+            .refs_found = snapshot_refs_found};
+}
+
+bool poll_finished_snapshot(void) {
+    return snapshot_finished.exchange(false);
+}
+
+std::shared_ptr<const SnapshotStats> get_snapshot_stats(void) {
+    const std::scoped_lock lock{graph_mutex};
+    return snapshot_stats;
+}
+
+void search_names(std::string_view name, std::vector<gui::SearchResult>& search_results) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+
+    auto pattern = std::format("%{}%", name);
+    for (internal::object_id id = 0; id < snapshot->num_objects(); id++) {
+        auto obj_name = snapshot->name(id);
+        if (!obj_name.empty() && like_match(pattern, obj_name)) {
+            append_result(*snapshot, id, obj_name, search_results);
+        }
+    }
+}
+
+void search_refs_to(std::string_view name, std::vector<gui::SearchResult>& search_results) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+    auto id = snapshot->find_name(name);
+    if (id == internal::Graph::INVALID_ID) {
+        return;
+    }
+    append_results(*snapshot, snapshot->refs_to(id), search_results);
+}
+
+void search_refs_from(std::string_view name, std::vector<gui::SearchResult>& search_results) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+    auto id = snapshot->find_name(name);
+    if (id == internal::Graph::INVALID_ID) {
+        return;
+    }
+    append_results(*snapshot, snapshot->refs_from(id), search_results);
+}
+
+void search_refs_to(std::string_view name,
+                    GroupBy group_by,
+                    std::vector<gui::SearchResultGroup>& search_groups) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+    auto id = snapshot->find_name(name);
+    if (id == internal::Graph::INVALID_ID) {
+        return;
+    }
+    append_groups(snapshot, snapshot->refs_to(id), get_group_kind(group_by),
+                  [id](const internal::Graph& snapshot) { return snapshot.refs_to(id); }, {},
+                  nullptr, search_groups);
+}
+
+void search_refs_from(std::string_view name,
+                      GroupBy group_by,
+                      std::vector<gui::SearchResultGroup>& search_groups) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+    auto id = snapshot->find_name(name);
+    if (id == internal::Graph::INVALID_ID) {
+        return;
+    }
+    append_groups(snapshot, snapshot->refs_from(id), get_group_kind(group_by),
+                  [id](const internal::Graph& snapshot) { return snapshot.refs_from(id); }, {},
+                  nullptr, search_groups);
+}
+
+void cancel_search(void) {
+    search_thread.request_stop();
+
+    // Also drop anything which finished but hasn't been polled yet
+    const std::scoped_lock lock{finished_search_mutex};
+    finished_search.reset();
+}
+
+bool is_searching(void) {
+    return search_running;
+}
+
+bool poll_search(std::vector<gui::SearchResult>& search_results,
+                 std::vector<gui::SearchResultGroup>& search_groups,
+                 std::vector<gui::RetainerResult>& retainer_results) {
+    const std::scoped_lock lock{finished_search_mutex};
+    if (!finished_search.has_value()) {
+        return false;
+    }
+    std::ranges::move(finished_search->results, std::back_inserter(search_results));
+    std::ranges::move(finished_search->groups, std::back_inserter(search_groups));
+    std::ranges::move(finished_search->retainers, std::back_inserter(retainer_results));
+    finished_search.reset();
+    return true;
+}
+
+void start_search_refs_within(std::string_view name,
+                              RefDirection direction,
+                              size_t max_depth,
+                              std::string_view class_filter) {
+    start_search([name = std::string{name}, direction, max_depth,
+                  class_filter = std::string{class_filter}](const std::stop_token& stop_token,
+                                                            SearchOutput& output) {
+        run_search_refs_within(name, direction, max_depth, class_filter, output.groups,
+                               stop_token);
+    });
+}
+
+void search_path_to(std::string_view name,
+                    RootSet root_set,
+                    std::string_view root_name,
+                    std::vector<gui::SearchResult>& search_results) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+    auto target = snapshot->find_name(name);
+    if (target == internal::Graph::INVALID_ID) {
+        return;
+    }
+
+    auto roots = get_path_roots(*snapshot, root_set, root_name);
+    auto path = internal::find_shortest_path(*snapshot, roots, target);
+    if (path.empty()) {
+        return;
+    }
+
+    // The graph doesn't know which property each ref came from, so look it up on the live objects,
+    // only a handful of them need checking
+    internal::RefLayoutCache layouts{};
+    for (size_t i = 0; i < path.size(); i++) {
+        auto obj_name = snapshot->name(path[i]);
+        append_result(*snapshot, path[i], obj_name.empty() ? "Unknown" : obj_name, search_results);
+
+        auto& note = search_results.back().note;
+        if (i + 1 == path.size()) {
+            note = i == 0 ? "root" : "target";
+            continue;
+        }
+
+        auto from_obj = find_live_object(*snapshot, path[i]);
+        auto to_obj = find_live_object(*snapshot, path[i + 1]);
+        auto prop = from_obj == nullptr || to_obj == nullptr
+                        ? std::string{}
+                        : internal::describe_ref(from_obj, to_obj, layouts);
+        if (prop.empty()) {
+            prop = "?";
+        }
+        note = i == 0 ? std::format("root, via {}", prop) : std::format("via {}", prop);
+    }
+}
+
+void start_diff_snapshots(std::string_view before_name, std::string_view after_name) {
+    // Look the snapshots up now, so we diff what was selected even if they get replaced meanwhile
+    start_search([before = find_snapshot(before_name), after = find_snapshot(after_name)](
+                     const std::stop_token& stop_token, SearchOutput& output) {
+        run_diff_snapshots(before, after, output.groups, stop_token);
+    });
+}
+
+void start_find_unreachable(std::optional<GroupBy> group_by) {
+    // Start any workers we need from here, so the search thread never has to start threads itself
+    const size_t thread_count = num_threads.load();
+    internal::reserve_workers(thread_count);
+
+    start_search([group_by, thread_count](const std::stop_token& stop_token, SearchOutput& output) {
+        run_find_unreachable(group_by, thread_count, output, stop_token);
+    });
+}
+
+void start_find_cycles(bool include_native_refs) {
+    start_search([include_native_refs](const std::stop_token& stop_token, SearchOutput& output) {
+        run_find_cycles(include_native_refs, output.groups, stop_token);
+    });
+}
+
+void save_snapshot(std::string_view name) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr || name.empty()) {
+        return;
+    }
+    const std::scoped_lock lock{graph_mutex};
+    saved_snapshots.insert_or_assign(std::string{name}, std::move(snapshot));
+}
+
+void delete_saved_snapshot(std::string_view name) {
+    const std::scoped_lock lock{graph_mutex};
+    auto iter = saved_snapshots.find(name);
+    if (iter != saved_snapshots.end()) {
+        saved_snapshots.erase(iter);
+    }
+}
+
+std::vector<std::string> get_saved_snapshots(void) {
+    const std::scoped_lock lock{graph_mutex};
+    std::vector<std::string> names{};
+    names.reserve(saved_snapshots.size());
+    for (const auto& [name, snapshot] : saved_snapshots) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+void import_snapshot(void) {
+    if (!std::filesystem::exists(get_local_snapshot_path())) {
+        LOG(ERROR, "Couldn't find snapshot file to import");
+        return;
+    }
+
+    auto snapshot = internal::read_snapshot_file(get_local_snapshot_path());
+    if (snapshot == nullptr) {
+        return;
+    }
+    set_graph(std::move(snapshot));
+}
+
+void export_snapshot(void) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
+        return;
+    }
+
+    auto path = get_local_snapshot_path();
+    if (!internal::write_snapshot_file(path, *snapshot)) {
+        std::error_code err{};
+        std::filesystem::remove(path, err);
+    }
+}
+
+void import_db(void) {
+    if (!std::filesystem::exists(get_local_db_path())) {
+        return;
+    }
 
     auto import_db = open_db(get_local_db_path().string().c_str());
     if (import_db == nullptr) {
         return;
     }
 
-    auto backup = sqlite3_backup_init(database.get(), "main", import_db.get(), "main");
-    if (backup == nullptr) {
-        LOG(ERROR, "Failed to create backup object: {}", sqlite3_errmsg(database.get()));
-        BREAKPOINT();
+    int64_t version = 0;
+    if (!for_each_row(import_db.get(), "get version", "PRAGMA user_version",
+                      [&version](sqlite3_stmt* statement) {
+                          version = sqlite3_column_int64(statement, 0);
+                      })) {
         return;
     }
-    const RaiiLambda raii2{[&]() {
-        auto ret = sqlite3_backup_finish(backup);
-        if (ret != SQLITE_OK) {
-            LOG(ERROR, "Failed to free backup object: {}", sqlite3_errstr(ret));
-            BREAKPOINT();
+    if (version != DB_SCHEMA_VERSION) {
+        LOG(ERROR, "Can't import database with schema version {}, expected {}", version,
+            DB_SCHEMA_VERSION);
+        return;
+    }
+
+    std::vector<internal::GraphShard> shards(1);
+    auto& shard = shards.front();
+
+    // Since ids are dense and we read them in order, an object's id is it's index in here, and in
+    // the shard's objects
+    std::vector<uintptr_t> pointers{};
+    // Classes and outers may come later in the table, so only resolve them once we have every id
+    std::vector<std::pair<sqlite_int64, sqlite_int64>> class_outer_ids{};
+    bool ids_valid = true;
+
+    if (!for_each_row(import_db.get(), "import objects",
+                      "SELECT Id, Pointer, ObjectIndex, ClassId, OuterId, Flags, ShallowSize, Name "
+                      "FROM Objects ORDER BY Id",
+                      [&shard, &pointers, &class_outer_ids, &ids_valid](sqlite3_stmt* statement) {
+                          if (sqlite3_column_int64(statement, 0)
+                              != static_cast<sqlite_int64>(pointers.size())) {
+                              ids_valid = false;
+                              return;
+                          }
+                          auto ptr = static_cast<uintptr_t>(sqlite3_column_int64(statement, 1));
+                          auto gobjects_idx =
+                              sqlite3_column_type(statement, 2) == SQLITE_NULL
+                                  ? internal::UNKNOWN_GOBJECTS_IDX
+                                  : static_cast<uint32_t>(sqlite3_column_int64(statement, 2));
+                          auto get_id = [statement](int column) -> sqlite_int64 {
+                              return sqlite3_column_type(statement, column) == SQLITE_NULL
+                                         ? -1
+                                         : sqlite3_column_int64(statement, column);
+                          };
+                          class_outer_ids.emplace_back(get_id(3), get_id(4));
+                          auto flags = static_cast<uint8_t>(sqlite3_column_int64(statement, 5));
+                          auto shallow_size =
+                              static_cast<uint32_t>(sqlite3_column_int64(statement, 6));
+                          auto name = reinterpret_cast<const char*>(
+                              sqlite3_column_text(statement, 7));
+
+                          pointers.push_back(ptr);
+                          shard.add_object(ptr,
+                                           name == nullptr ? std::string_view{}
+                                                           : std::string_view{name},
+                                           gobjects_idx, 0, 0, flags, shallow_size);
+                      })) {
+        return;
+    }
+    if (!for_each_row(import_db.get(), "import refs", "SELECT FromId, ToId FROM Refs",
+                      [&shard, &pointers, &ids_valid](sqlite3_stmt* statement) {
+                          auto from = static_cast<size_t>(sqlite3_column_int64(statement, 0));
+                          auto to = static_cast<size_t>(sqlite3_column_int64(statement, 1));
+                          if (from >= pointers.size() || to >= pointers.size()) {
+                              ids_valid = false;
+                              return;
+                          }
+                          shard.refs.emplace_back(pointers[from], pointers[to]);
+                      })) {
+        return;
+    }
+
+    auto id_to_pointer = [&pointers, &ids_valid](sqlite_int64 id) -> uintptr_t {
+        if (id < 0) {
+            return 0;
         }
-    }};
+        if (static_cast<size_t>(id) >= pointers.size()) {
+            ids_valid = false;
+            return 0;
+        }
+        return pointers[static_cast<size_t>(id)];
+    };
+    for (size_t i = 0; i < shard.objects.size() && ids_valid; i++) {
+        shard.objects[i].cls = id_to_pointer(class_outer_ids[i].first);
+        shard.objects[i].outer = id_to_pointer(class_outer_ids[i].second);
+    }
 
-    auto ret = sqlite3_backup_step(backup, -1);
-    if (ret != SQLITE_DONE) {
-        LOG(ERROR, "Failed to export database: {}", sqlite3_errmsg(database.get()));
-        BREAKPOINT();
+    if (!ids_valid) {
+        LOG(ERROR, "Failed to import database: invalid object ids");
+        return;
     }
 
-    // Successfully loaded, don't wipe
-    wipe_db_on_exit = false;
+    const size_t thread_count = num_threads.load();
+    internal::reserve_workers(thread_count);
+    set_graph(std::make_shared<const internal::Graph>(std::move(shards), thread_count));
 }
 
 void export_db(void) {
-    if (database == nullptr) {
+    auto snapshot = get_graph();
+    if (snapshot == nullptr) {
         return;
     }
 
-    auto export_db = open_db(get_local_db_path().string().c_str());
-    if (export_db == nullptr) {
+    // Bulk loading only works on a fresh database, and it's quicker to recreate everything than
+    // to try clear out an old one
+    auto path = get_local_db_path();
+    std::error_code err{};
+    std::filesystem::remove(path, err);
+    if (err) {
+        LOG(ERROR, "Failed to remove old database: {}", err.message());
         return;
     }
 
-    auto backup = sqlite3_backup_init(export_db.get(), "main", database.get(), "main");
-    if (backup == nullptr) {
-        LOG(ERROR, "Failed to create backup object: {}", sqlite3_errmsg(export_db.get()));
-        BREAKPOINT();
-        return;
-    }
+    // Since we turned off journaling, there's no way to roll back, instead get rid of the partial
+    // file on any error
+    bool success = false;
     const RaiiLambda raii{[&]() {
-        auto ret = sqlite3_backup_finish(backup);
-        if (ret != SQLITE_OK) {
-            LOG(ERROR, "Failed to free backup object: {}", sqlite3_errstr(ret));
-            BREAKPOINT();
+        if (!success) {
+            std::filesystem::remove(path, err);
         }
     }};
 
-    auto ret = sqlite3_backup_step(backup, -1);
-    if (ret != SQLITE_DONE) {
-        LOG(ERROR, "Failed to export database: {}", sqlite3_errmsg(export_db.get()));
-        BREAKPOINT();
+    auto export_db = open_db(path.string().c_str());
+    if (export_db == nullptr) {
         return;
     }
+
+    success = start_bulk_load(export_db.get()) && write_graph(export_db.get(), *snapshot)
+              && finish_bulk_load(export_db.get());
+}
+
+void shutdown(bool process_exiting) {
+    stop_background_thread(snapshot_thread, snapshot_running, process_exiting);
+    stop_background_thread(search_thread, search_running, process_exiting);
+
+    // The workers would otherwise get joined while destroying statics, under the loader lock. Now
+    // the jobs are stopped the pool should be idle, so just leave them parked.
+    internal::release_workers(!process_exiting);
 }
 
 void init(void) {
     // The only thing there actually is to initialise is reading your threads setting
-    auto setting = unrealsdk::config::get_int("live_object_explorer.snapshot_threads");
-    constexpr auto threshold = 64;
-    if (setting.has_value() && 1 <= *setting && *setting <= threshold) {
-        num_threads = static_cast<uint32_t>(*setting);
+    auto setting = unrealsdk::config::get_int("live_object_explorer.snapshot_threads").value_or(-1);
+    if (setting <= 0) {
+        // Auto - one per core. The workers are purely cpu bound, more wouldn't help.
+        num_threads = std::clamp(std::thread::hardware_concurrency(), 1U, MAX_THREADS);
+    } else {
+        num_threads = static_cast<uint32_t>(std::min<int64_t>(setting, MAX_THREADS));
     }
 };
 
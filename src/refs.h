@@ -6,14 +6,27 @@
 
 namespace live_object_explorer::refs {
 
-// Variable controlling how many threads we use while taking a snapshot.
-extern uint32_t num_threads;
+// Variable controlling how many threads we use while taking a snapshot. Atomic since it's set from
+// the gui, while background jobs read it.
+extern std::atomic<uint32_t> num_threads;
+// The most threads we'll use, whether set from the config file or the gui
+constexpr uint32_t MAX_THREADS = 64;
 
 /**
  * @brief Initializes the references modules.
  */
 void init(void);
 
+/**
+ * @brief Shuts down the references module, cancelling and waiting for any background jobs.
+ * @note Must be called before the dll is unloaded, so no background thread is left running
+ *       unmapped code.
+ *
+ * @param process_exiting True if the whole process is exiting, and all other threads have already
+ *                        been terminated.
+ */
+void shutdown(bool process_exiting);
+
 /**
  * @brief Checks if we have a refs snapshot, and are able to search.
  *
@@ -22,9 +35,128 @@ void init(void);
 bool has_snapshot(void);
 
 /**
- * @brief Takes a new refs snapshot.
+ * @brief The progress of a snapshot being taken in the background.
+ */
+struct SnapshotProgress {
+    enum class Phase : uint8_t {
+        IDLE,
+        SCANNING,
+        NAMING,
+        BUILDING,
+    };
+
+    Phase phase;
+    // How many objects we've processed in the current phase, out of the total
+    size_t done;
+    size_t total;
+    size_t refs_found;
+};
+
+/**
+ * @brief Statistics about where the time went in the last snapshot we took.
+ */
+struct SnapshotStats {
+    using duration = std::chrono::steady_clock::duration;
+
+    // The total cost of scanning every object of a single class. Estimated, since we only time
+    // whole chunks of objects.
+    struct ClassCost {
+        std::string name;
+        size_t objects;
+        duration time;
+    };
+
+    uint32_t threads;
+    bool incremental;
+
+    // How long the game was frozen for, which is entirely spent discovering refs
+    duration suspended;
+    // How long we spent building names and the graph, after the game resumed
+    duration naming;
+    duration building;
+
+    size_t objects;
+    // How many objects we actually searched for refs, rather than skipping as unchanged
+    size_t objects_rescanned;
+    // How many refs we found while searching, and how many remained after deduplicating and
+    // copying over those of unchanged objects
+    size_t refs_found;
+    size_t refs_kept;
+    // How much memory the resulting graph takes up, in bytes
+    size_t memory_usage;
+
+    // The classes with the most expensive total scan time, most expensive first
+    std::vector<ClassCost> top_classes;
+};
+
+/**
+ * @brief Gets the stats of the last snapshot we finished taking.
+ *
+ * @return The stats, or nullptr if we haven't finished one yet.
+ */
+std::shared_ptr<const SnapshotStats> get_snapshot_stats(void);
+
+/**
+ * @brief Starts taking a new refs snapshot in the background.
+ * @note Does nothing if a snapshot is already being taken. Searches keep using the previous
+ *       snapshot until the new one is finished.
+ *
+ * @param incremental If true, only rescans objects which changed since the last snapshot we took.
+ *                    Falls back to a full snapshot if we haven't taken one yet.
+ */
+void take_snapshot(bool incremental);
+
+/**
+ * @brief Cancels the snapshot being taken in the background, if there is one.
+ */
+void cancel_snapshot(void);
+
+/**
+ * @brief Gets the progress of the snapshot being taken in the background.
+ *
+ * @return The progress. Has phase IDLE if there's no snapshot being taken.
+ */
+SnapshotProgress get_snapshot_progress(void);
+
+/**
+ * @brief Checks if a background snapshot has finished since the last time this was called.
+ *
+ * @return True if a new snapshot just became available.
+ */
+bool poll_finished_snapshot(void);
+
+/**
+ * @brief Keeps the current snapshot under the given name, so it can be diffed against later.
+ * @note Replaces any snapshot already saved under the same name. Snapshots are never modified, so
+ *       this doesn't copy anything, but it does keep the whole snapshot in memory.
+ *
+ * @param name The name to save the snapshot as. Must not be empty.
  */
-void take_snapshot(void);
+void save_snapshot(std::string_view name);
+
+/**
+ * @brief Deletes a saved snapshot.
+ *
+ * @param name The name of the snapshot to delete.
+ */
+void delete_saved_snapshot(std::string_view name);
+
+/**
+ * @brief Gets the names of all saved snapshots.
+ *
+ * @return The names, sorted.
+ */
+std::vector<std::string> get_saved_snapshots(void);
+
+/**
+ * @brief Imports a refs snapshot from disk, in our native file format.
+ */
+void import_snapshot(void);
+
+/**
+ * @brief Exports the current refs snapshot to disk, in our native file format.
+ */
+void export_snapshot(void);
 
 /**
  * @brief Imports a refs db from disk.
@@ -60,6 +192,165 @@ void search_refs_to(std::string_view name, std::vector<gui::SearchResult>& searc
  */
 void search_refs_from(std::string_view name, std::vector<gui::SearchResult>& search_results);
 
+/**
+ * @brief What to group refs search results by.
+ */
+enum class GroupBy : uint8_t {
+    CLASS,
+    PACKAGE,
+};
+
+/**
+ * @brief Search for references to the given object, grouped by the referencing objects' class or
+ *        package.
+ * @note Only counts each group up front, each group's results are only filled in when expanded.
+ *
+ * @param name The object name to search for.
+ * @param group_by What to group results by.
+ * @param search_groups A vector to append search result groups to.
+ */
+void search_refs_to(std::string_view name,
+                    GroupBy group_by,
+                    std::vector<gui::SearchResultGroup>& search_groups);
+
+/**
+ * @brief Search for references from the given object, grouped by the referenced objects' class or
+ *        package.
+ * @note Only counts each group up front, each group's results are only filled in when expanded.
+ *
+ * @param name The object name to search for.
+ * @param group_by What to group results by.
+ * @param search_groups A vector to append search result groups to.
+ */
+void search_refs_from(std::string_view name,
+                      GroupBy group_by,
+                      std::vector<gui::SearchResultGroup>& search_groups);
+
+/**
+ * @brief Which way to follow refs, when searching more than one ref deep.
+ */
+enum class RefDirection : uint8_t {
+    TO,
+    FROM,
+};
+
+// The most refs a transitive refs search may follow
+constexpr size_t MAX_REF_DEPTH = 6;
+
+/**
+ * @brief Cancels the search running in the background, if there is one. It's results are
+ *        discarded.
+ */
+void cancel_search(void);
+
+/**
+ * @brief Checks if a search is running in the background.
+ *
+ * @return True if a search is running.
+ */
+bool is_searching(void);
+
+/**
+ * @brief Checks if a background search has finished since the last time this was called.
+ *
+ * @param search_results A vector to append the finished search's results to.
+ * @param search_groups A vector to append the finished search's groups to.
+ * @param retainer_results A vector to append the finished search's retainer results to.
+ * @return True if a search just finished.
+ */
+bool poll_search(std::vector<gui::SearchResult>& search_results,
+                 std::vector<gui::SearchResultGroup>& search_groups,
+                 std::vector<gui::RetainerResult>& retainer_results);
+
+/**
+ * @brief Starts searching for all objects within a number of refs of the given object in the
+ *        background. Results are grouped by distance.
+ * @note Cancels any background search which was already running. Stops early after finding a
+ *       large number of objects, in which case the deepest group's name says so.
+ *
+ * @param name The object name to search for.
+ * @param direction Which way to follow refs.
+ * @param max_depth The most refs to follow, between 1 and `MAX_REF_DEPTH`.
+ * @param class_filter If not empty, a sql LIKE pattern which only reports objects whose class
+ *                     matches. Matched against both the class's full name and it's last part.
+ */
+void start_search_refs_within(std::string_view name,
+                              RefDirection direction,
+                              size_t max_depth,
+                              std::string_view class_filter);
+
+/**
+ * @brief Which objects to start from, when searching for what keeps an object alive.
+ */
+enum class RootSet : uint8_t {
+    // Objects the engine flagged as always being kept alive
+    FLAGGED,
+    // The engine and world singletons
+    SINGLETONS,
+    // A single specific object
+    OBJECT,
+};
+
+/**
+ * @brief Search for the shortest chain of references leading to the given object.
+ * @note Each step's note gives the property holding the ref to the next step, which is looked up
+ *       on the live objects, so may be missing if they've since changed.
+ *
+ * @param name The object name to search for.
+ * @param root_set Which objects to start the chain from.
+ * @param root_name If using a single root object, it's name.
+ * @param search_results A vector to append search results to.
+ */
+void search_path_to(std::string_view name,
+                    RootSet root_set,
+                    std::string_view root_name,
+                    std::vector<gui::SearchResult>& search_results);
+
+/**
+ * @brief Starts finding the objects which keep the most memory alive in the background.
+ * @note Builds the snapshot's dominator tree, an object's retained size is the total size of it
+ *       and everything which is only reachable through it. Results are sorted largest retained
+ *       size first.
+ * @note Cancels any background search which was already running.
+ *
+ * @param root_set Which objects to treat as roots.
+ * @param root_name If using a single root object, it's name.
+ */
+void start_find_top_retainers(RootSet root_set, std::string_view root_name);
+
+/**
+ * @brief Starts working out which objects were added, removed, or had their refs changed between
+ *        two snapshots in the background, grouped by class.
+ * @note Cancels any background search which was already running.
+ *
+ * @param before_name The name of the earlier saved snapshot, or empty to use the current one.
+ * @param after_name The name of the later saved snapshot, or empty to use the current one.
+ */
+void start_diff_snapshots(std::string_view before_name, std::string_view after_name);
+
+/**
+ * @brief Starts finding all objects which can't be reached from anything the garbage collector
+ *        keeps alive in the background, optionally grouped by class or package.
+ * @note The roots are flagged objects, class default objects, and the engine and world singletons.
+ *       Anything not reachable from them should have been collected, so is a leak candidate.
+ * @note Cancels any background search which was already running.
+ *
+ * @param group_by What to group results by, or an empty optional for a flat list.
+ */
+void start_find_unreachable(std::optional<GroupBy> group_by);
+
+/**
+ * @brief Starts finding all reference cycles in the current snapshot in the background, one group
+ *        per cycle.
+ * @note A cycle is a set of objects which can all reach each other, so it may contain many
+ *       overlapping loops. Groups are sorted largest first, and named by their most common classes.
+ * @note Cancels any background search which was already running.
+ *
+ * @param include_native_refs If false, ignores refs from native fields, such as each object's
+ *                            Class and Outer, and the links between UFields.
+ */
+void start_find_cycles(bool include_native_refs);
+
 }  // namespace live_object_explorer::refs
 
 #endif /* REFS_H */
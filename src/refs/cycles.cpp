@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "refs/cycles.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+constexpr uint32_t UNVISITED = std::numeric_limits<uint32_t>::max();
+
+// How many objects to visit between checking if we've been cancelled
+constexpr uint32_t STOP_CHECK_INTERVAL = 0x400;
+
+}  // namespace
+
+size_t Components::size(void) const {
+    return this->offsets.empty() ? 0 : this->offsets.size() - 1;
+}
+
+std::span<const object_id> Components::operator[](size_t idx) const {
+    return std::span{this->members}.subspan(this->offsets[idx],
+                                            this->offsets[idx + 1] - this->offsets[idx]);
+}
+
+bool is_native_ref(const Graph& graph, object_id from, object_id to) {
+    return (graph.flags(from) & OBJECT_FLAG_FIELD) != 0 || to == graph.class_id(from)
+           || to == graph.outer_id(from);
+}
+
+Components find_cycles(const Graph& graph,
+                       bool include_native_refs,
+                       const std::stop_token& stop_token) {
+    auto num_objects = graph.num_objects();
+
+    // The order we first visited each object in, and the lowest visit order reachable from it
+    std::vector<uint32_t> indexes(num_objects, UNVISITED);
+    std::vector<uint32_t> low_links(num_objects, UNVISITED);
+    std::vector<bool> on_stack(num_objects, false);
+    uint32_t next_index = 0;
+
+    // The objects on the current path, and how many of each one's refs we've followed
+    std::vector<std::pair<object_id, size_t>> call_stack{};
+    // Visited objects which haven't been assigned a component yet
+    std::vector<object_id> component_stack{};
+
+    Components found{};
+    found.offsets.push_back(0);
+
+    auto visit = [&](object_id id) {
+        indexes[id] = low_links[id] = next_index++;
+        on_stack[id] = true;
+        component_stack.push_back(id);
+        call_stack.emplace_back(id, 0);
+    };
+
+    for (object_id start = 0; start < num_objects; start++) {
+        if (indexes[start] != UNVISITED) {
+            continue;
+        }
+        visit(start);
+
+        while (!call_stack.empty()) {
+            if (next_index % STOP_CHECK_INTERVAL == 0 && stop_token.stop_requested()) {
+                return {};
+            }
+
+            auto [id, next_ref] = call_stack.back();
+            auto refs = graph.refs_from(id);
+
+            if (next_ref < refs.size()) {
+                call_stack.back().second++;
+                auto ref = refs[next_ref];
+                if (!include_native_refs && is_native_ref(graph, id, ref)) {
+                    continue;
+                }
+                if (indexes[ref] == UNVISITED) {
+                    visit(ref);
+                } else if (on_stack[ref]) {
+                    low_links[id] = std::min(low_links[id], indexes[ref]);
+                }
+                continue;
+            }
+
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                auto parent = call_stack.back().first;
+                low_links[parent] = std::min(low_links[parent], low_links[id]);
+            }
+            if (low_links[id] != indexes[id]) {
+                continue;
+            }
+
+            // This object's the root of a component, everything above it on the stack is in it
+            auto start_idx = found.members.size();
+            object_id member = Graph::INVALID_ID;
+            do {
+                member = component_stack.back();
+                component_stack.pop_back();
+                on_stack[member] = false;
+                found.members.push_back(member);
+            } while (member != id);
+
+            // Single objects aren't cycles, even if they reference themselves
+            if (found.members.size() - start_idx == 1) {
+                found.members.pop_back();
+            } else {
+                std::sort(found.members.begin() + static_cast<ptrdiff_t>(start_idx),
+                          found.members.end());
+                found.offsets.push_back(found.members.size());
+            }
+        }
+    }
+
+    // Reorder largest first
+    std::vector<size_t> order(found.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, std::ranges::greater{},
+                             [&found](size_t idx) { return found[idx].size(); });
+
+    Components sorted{};
+    sorted.members.reserve(found.members.size());
+    sorted.offsets.reserve(found.offsets.size());
+    sorted.offsets.push_back(0);
+    for (auto idx : order) {
+        auto members = found[idx];
+        sorted.members.insert(sorted.members.end(), members.begin(), members.end());
+        sorted.offsets.push_back(sorted.members.size());
+    }
+    return sorted;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,64 @@
+#ifndef REFS_CYCLES_H
+#define REFS_CYCLES_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief A set of strongly connected components, where every member of a component can reach
+ *        every other member.
+ */
+struct Components {
+    // The members of every component, grouped together
+    std::vector<object_id> members;
+    // The offset of each component within the members, plus one past the end
+    std::vector<size_t> offsets;
+
+    /**
+     * @brief Gets how many components there are.
+     *
+     * @return The number of components.
+     */
+    [[nodiscard]] size_t size(void) const;
+
+    /**
+     * @brief Gets the members of a component.
+     *
+     * @param idx The index of the component.
+     * @return The component's members, sorted.
+     */
+    [[nodiscard]] std::span<const object_id> operator[](size_t idx) const;
+};
+
+/**
+ * @brief Checks if a ref only comes from a native field, rather than from a property.
+ * @note This is inferred, since the graph doesn't record where refs came from. It counts the refs
+ *       to an object's class and outer, and every ref held by a UField.
+ *
+ * @param graph The graph the ref is in.
+ * @param from The referencing object.
+ * @param to The referenced object.
+ * @return True if the ref is native.
+ */
+[[nodiscard]] bool is_native_ref(const Graph& graph, object_id from, object_id to);
+
+/**
+ * @brief Finds all reference cycles in a graph.
+ * @note Uses an iterative version of Tarjan's algorithm, so arbitrarily deep graphs can't overflow
+ *       the stack.
+ *
+ * @param graph The graph to search.
+ * @param include_native_refs If false, ignores any refs which only come from native fields.
+ * @param stop_token A stop token, to cancel the search early.
+ * @return Every strongly connected component with more than one member, largest first. Empty if
+ *         cancelled.
+ */
+[[nodiscard]] Components find_cycles(const Graph& graph,
+                                     bool include_native_refs,
+                                     const std::stop_token& stop_token);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_CYCLES_H */
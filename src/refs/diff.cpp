@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "refs/diff.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+// How many objects to compare refs of between checking if we've been cancelled
+constexpr object_id STOP_CHECK_INTERVAL = 0x400;
+
+/**
+ * @brief Matches up the objects which exist in both graphs.
+ *
+ * @param before The earlier snapshot.
+ * @param after The later snapshot.
+ * @param diff The diff to add any added or removed objects to.
+ * @return The id each object in the before graph has in the after graph, or INVALID_ID if it no
+ *         longer exists.
+ */
+std::vector<object_id> match_objects(const Graph& before, const Graph& after, SnapshotDiff& diff) {
+    std::vector<object_id> before_to_after(before.num_objects(), Graph::INVALID_ID);
+
+    object_id before_id = 0;
+    object_id after_id = 0;
+    while (before_id < before.num_objects() && after_id < after.num_objects()) {
+        auto before_ptr = before.pointer(before_id);
+        auto after_ptr = after.pointer(after_id);
+        if (before_ptr < after_ptr) {
+            diff.removed.push_back(before_id++);
+        } else if (after_ptr < before_ptr) {
+            diff.added.push_back(after_id++);
+        } else if (before.name(before_id) != after.name(after_id)) {
+            // Same address, but a different object
+            diff.removed.push_back(before_id++);
+            diff.added.push_back(after_id++);
+        } else {
+            before_to_after[before_id++] = after_id++;
+        }
+    }
+    for (; before_id < before.num_objects(); before_id++) {
+        diff.removed.push_back(before_id);
+    }
+    for (; after_id < after.num_objects(); after_id++) {
+        diff.added.push_back(after_id);
+    }
+
+    return before_to_after;
+}
+
+}  // namespace
+
+SnapshotDiff diff_graphs(const Graph& before,
+                         const Graph& after,
+                         const std::stop_token& stop_token) {
+    SnapshotDiff diff{};
+    auto before_to_after = match_objects(before, after, diff);
+
+    for (object_id before_id = 0; before_id < before.num_objects(); before_id++) {
+        if (before_id % STOP_CHECK_INTERVAL == 0 && stop_token.stop_requested()) {
+            return {};
+        }
+        auto after_id = before_to_after[before_id];
+        if (after_id == Graph::INVALID_ID) {
+            continue;
+        }
+
+        // Ids are assigned in address order in both graphs, so mapping the before refs across
+        // keeps them sorted, and we can merge them against the after refs directly
+        auto before_refs = before.refs_from(before_id);
+        auto after_refs = after.refs_from(after_id);
+        size_t refs_added = 0;
+        size_t refs_removed = 0;
+
+        size_t before_idx = 0;
+        size_t after_idx = 0;
+        while (before_idx < before_refs.size() && after_idx < after_refs.size()) {
+            auto mapped = before_to_after[before_refs[before_idx]];
+            if (mapped == Graph::INVALID_ID) {
+                // The referenced object's gone, so this ref must have been removed
+                refs_removed++;
+                before_idx++;
+            } else if (mapped < after_refs[after_idx]) {
+                refs_removed++;
+                before_idx++;
+            } else if (after_refs[after_idx] < mapped) {
+                refs_added++;
+                after_idx++;
+            } else {
+                before_idx++;
+                after_idx++;
+            }
+        }
+        refs_removed += before_refs.size() - before_idx;
+        refs_added += after_refs.size() - after_idx;
+
+        if (refs_added != 0 || refs_removed != 0) {
+            diff.changed.push_back({.before_id = before_id,
+                                    .after_id = after_id,
+                                    .refs_added = refs_added,
+                                    .refs_removed = refs_removed});
+        }
+    }
+
+    return diff;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,48 @@
+#ifndef REFS_DIFF_H
+#define REFS_DIFF_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief An object which exists in both snapshots, but whose refs changed.
+ */
+struct ChangedObject {
+    object_id before_id;
+    object_id after_id;
+    size_t refs_added;
+    size_t refs_removed;
+};
+
+/**
+ * @brief The differences between two snapshots.
+ */
+struct SnapshotDiff {
+    // Ids in the after graph of objects which didn't exist before, sorted
+    std::vector<object_id> added;
+    // Ids in the before graph of objects which no longer exist, sorted
+    std::vector<object_id> removed;
+    // Objects whose refs changed, sorted by id
+    std::vector<ChangedObject> changed;
+};
+
+/**
+ * @brief Works out what changed between two snapshots.
+ * @note Objects are matched up by address and name, so an address which got reused by a different
+ *       object counts as one removed and one added. Since both graphs are already sorted by
+ *       address, this is a single linear merge over the objects, and then over each one's refs.
+ *
+ * @param before The earlier snapshot.
+ * @param after The later snapshot.
+ * @param stop_token A stop token, to cancel the diff early.
+ * @return The differences. Empty if cancelled.
+ */
+[[nodiscard]] SnapshotDiff diff_graphs(const Graph& before,
+                                       const Graph& after,
+                                       const std::stop_token& stop_token);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_DIFF_H */
@@ -0,0 +1,222 @@
+#include "pch.h"
+#include "refs/dominators.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+// Vertices are numbered in depth first order, with a virtual root linking to every real root at 0
+using dfs_num = uint32_t;
+constexpr dfs_num VIRTUAL_ROOT = 0;
+constexpr dfs_num UNVISITED = std::numeric_limits<dfs_num>::max();
+
+// How many vertices to process between checking if we've been cancelled
+constexpr size_t STOP_CHECK_INTERVAL = 0x400;
+
+/**
+ * @brief The depth first spanning tree of everything reachable from the roots.
+ */
+struct SpanningTree {
+    // The object at each dfs number, and the dfs number of each object
+    std::vector<object_id> vertices;
+    std::vector<dfs_num> nums;
+    // The dfs number of each vertex's parent in the tree
+    std::vector<dfs_num> parents;
+};
+
+/**
+ * @brief Walks the graph depth first, numbering everything reachable from the roots.
+ *
+ * @param graph The graph to walk.
+ * @param roots The objects to start from.
+ * @param stop_token A stop token, to cancel the walk early.
+ * @return The spanning tree. Only partially filled in if cancelled.
+ */
+SpanningTree build_spanning_tree(const Graph& graph,
+                                 std::span<const object_id> roots,
+                                 const std::stop_token& stop_token) {
+    SpanningTree tree{
+        .vertices = {Graph::INVALID_ID},
+        .nums = std::vector<dfs_num>(graph.num_objects(), UNVISITED),
+        .parents = {VIRTUAL_ROOT},
+    };
+
+    auto visit = [&tree](object_id id, dfs_num parent) {
+        tree.nums[id] = static_cast<dfs_num>(tree.vertices.size());
+        tree.vertices.push_back(id);
+        tree.parents.push_back(parent);
+    };
+
+    // An explicit stack of each object on the current path, and how many of it's refs we've
+    // followed, so deep chains can't overflow the real stack
+    std::vector<std::pair<object_id, size_t>> stack{};
+    for (auto root : roots) {
+        if (tree.nums[root] != UNVISITED) {
+            continue;
+        }
+        visit(root, VIRTUAL_ROOT);
+        stack.emplace_back(root, 0);
+
+        while (!stack.empty()) {
+            auto& [id, next_ref] = stack.back();
+            auto refs = graph.refs_from(id);
+            if (next_ref == refs.size()) {
+                stack.pop_back();
+                continue;
+            }
+            auto ref = refs[next_ref++];
+            if (tree.nums[ref] == UNVISITED) {
+                visit(ref, tree.nums[id]);
+                stack.emplace_back(ref, 0);
+
+                if (tree.vertices.size() % STOP_CHECK_INTERVAL == 0
+                    && stop_token.stop_requested()) {
+                    return tree;
+                }
+            }
+        }
+    }
+    return tree;
+}
+
+/**
+ * @brief The working state of each vertex while finding semidominators.
+ * @note Kept together since they're almost always accessed together, and the vertices we visit are
+ *       scattered all over the place.
+ */
+struct VertexState {
+    // The vertex's ancestor in the forest, modified by path compression
+    dfs_num ancestor;
+    // The vertex with the smallest semidominator on the compressed path above this one
+    dfs_num label;
+    dfs_num semi;
+};
+
+/**
+ * @brief Finds the vertex with the smallest semidominator on the path from a vertex up to the
+ *        already processed part of the tree, compressing the path as it goes.
+ *
+ * @param num The vertex to start at.
+ * @param last_linked The lowest vertex which has been linked into the forest.
+ * @param states The state of each vertex.
+ * @param stack Scratch space.
+ * @return The vertex with the smallest semidominator.
+ */
+dfs_num eval(dfs_num num,
+             dfs_num last_linked,
+             std::vector<VertexState>& states,
+             std::vector<dfs_num>& stack) {
+    if (states[num].ancestor < last_linked) {
+        return states[num].label;
+    }
+
+    // Gather the path, except for the last vertex, whose ancestor is already unlinked
+    do {
+        stack.push_back(num);
+        num = states[num].ancestor;
+    } while (states[num].ancestor >= last_linked);
+
+    // Point each vertex on the path at the top, carrying down the smallest semidominator
+    auto top = num;
+    auto top_label = states[top].label;
+    do {
+        num = stack.back();
+        stack.pop_back();
+        auto& state = states[num];
+        state.ancestor = states[top].ancestor;
+        if (states[top_label].semi < states[state.label].semi) {
+            state.label = top_label;
+        } else {
+            top_label = state.label;
+        }
+        top = num;
+    } while (!stack.empty());
+    return states[num].label;
+}
+
+}  // namespace
+
+DominatorTree build_dominator_tree(const Graph& graph,
+                                   std::span<const object_id> roots,
+                                   const std::stop_token& stop_token) {
+    auto tree = build_spanning_tree(graph, roots, stop_token);
+    if (stop_token.stop_requested()) {
+        return {};
+    }
+    auto num_vertices = static_cast<dfs_num>(tree.vertices.size());
+
+    std::vector<bool> is_root(graph.num_objects(), false);
+    for (auto root : roots) {
+        is_root[root] = true;
+    }
+
+    // Start with each vertex's dominator as it's parent, and refine it once we know the
+    // semidominators
+    std::vector<dfs_num> idoms = tree.parents;
+    std::vector<VertexState> states(num_vertices);
+    for (dfs_num num = 0; num < num_vertices; num++) {
+        states[num] = {.ancestor = tree.parents[num], .label = num, .semi = num};
+    }
+    tree.parents = {};
+
+    std::vector<dfs_num> stack{};
+    std::vector<dfs_num> preds{};
+    for (auto num = num_vertices - 1; num > VIRTUAL_ROOT; num--) {
+        if (num % STOP_CHECK_INTERVAL == 0 && stop_token.stop_requested()) {
+            return {};
+        }
+        auto id = tree.vertices[num];
+
+        // Look up all the preds before evaluating any of them, these lookups are all independent,
+        // so they can overlap rather than each waiting on the last
+        preds.clear();
+        if (is_root[id]) {
+            preds.push_back(VIRTUAL_ROOT);
+        }
+        for (auto pred : graph.refs_to(id)) {
+            auto pred_num = tree.nums[pred];
+            if (pred_num != UNVISITED) {
+                preds.push_back(pred_num);
+            }
+        }
+
+        auto semi = states[num].ancestor;
+        for (auto pred : preds) {
+            semi = std::min(semi, states[eval(pred, num + 1, states, stack)].semi);
+        }
+        states[num].semi = semi;
+    }
+
+    // The dominator is the nearest common ancestor of the parent and the semidominator, and
+    // dominators always have lower numbers, so walk up until we're no higher than it
+    for (dfs_num num = 1; num < num_vertices; num++) {
+        auto idom = idoms[num];
+        while (idom > states[num].semi) {
+            idom = idoms[idom];
+        }
+        idoms[num] = idom;
+    }
+
+    // Children always have higher numbers than their dominators, so one reverse pass pushes every
+    // size all the way up the tree
+    std::vector<uint64_t> retained(num_vertices, 0);
+    for (dfs_num num = num_vertices - 1; num > VIRTUAL_ROOT; num--) {
+        retained[num] += graph.shallow_size(tree.vertices[num]);
+        retained[idoms[num]] += retained[num];
+    }
+
+    DominatorTree dominators{
+        .idoms = std::vector<object_id>(graph.num_objects(), Graph::INVALID_ID),
+        .retained_sizes = std::vector<uint64_t>(graph.num_objects(), 0),
+    };
+    for (dfs_num num = 1; num < num_vertices; num++) {
+        auto id = tree.vertices[num];
+        dominators.idoms[id] = idoms[num] == VIRTUAL_ROOT ? DominatorTree::ROOT_SET
+                                                          : tree.vertices[idoms[num]];
+        dominators.retained_sizes[id] = retained[num];
+    }
+    return dominators;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,41 @@
+#ifndef REFS_DOMINATORS_H
+#define REFS_DOMINATORS_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Which object keeps each other object alive, and how much memory each one keeps alive.
+ * @note An object dominates another if every path from the roots to the other passes through it,
+ *       so freeing the dominator would free everything it dominates.
+ */
+struct DominatorTree {
+    // Used as the dominator of objects which are only dominated by the root set as a whole
+    static constexpr object_id ROOT_SET = Graph::INVALID_ID - 1;
+
+    // The immediate dominator of each object. ROOT_SET if it's only dominated by the roots
+    // themselves, or INVALID_ID if it's not reachable from them.
+    std::vector<object_id> idoms;
+    // The total shallow size of each object, and everything it dominates. Zero if unreachable.
+    std::vector<uint64_t> retained_sizes;
+};
+
+/**
+ * @brief Builds the dominator tree of a graph.
+ * @note Uses the semi-NCA algorithm, all iterative and over flat arrays, so it runs in near
+ *       linear time no matter how deep the graph gets.
+ *
+ * @param graph The graph to build the dominator tree of.
+ * @param roots The objects to start from.
+ * @param stop_token A stop token, to cancel building the tree early.
+ * @return The dominator tree, or an empty one if cancelled.
+ */
+[[nodiscard]] DominatorTree build_dominator_tree(const Graph& graph,
+                                                 std::span<const object_id> roots,
+                                                 const std::stop_token& stop_token);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_DOMINATORS_H */
@@ -0,0 +1,407 @@
+#include "pch.h"
+#include "refs/graph.h"
+#include "refs/radix_sort.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+// Never a valid object address, used to start off tracking the last ref's from object
+constexpr uintptr_t NO_POINTER = std::numeric_limits<uintptr_t>::max();
+
+/**
+ * @brief Fills in a CSR offsets array from a list of sorted source ids.
+ *
+ * @param offsets The offsets array to fill. Should be sized one more than the number of objects.
+ * @param sorted_sources The sorted list of source ids of each ref.
+ */
+void fill_offsets(std::vector<size_t>& offsets, const std::vector<object_id>& sorted_sources) {
+    size_t ref_idx = 0;
+    for (size_t id = 0; id < offsets.size(); id++) {
+        while (ref_idx < sorted_sources.size() && sorted_sources[ref_idx] < id) {
+            ref_idx++;
+        }
+        offsets[id] = ref_idx;
+    }
+}
+
+/**
+ * @brief A hash table from pointers to ids, used to convert refs while building a graph.
+ * @note Binary searching the sorted pointers costs a cache miss on almost every step, and we need
+ *       to look up tens of millions of refs. A hash lookup costs about two.
+ */
+class PointerIndex {
+   public:
+    /**
+     * @brief Builds a new index.
+     *
+     * @param pointers The sorted pointers to index. Must outlive the index.
+     */
+    explicit PointerIndex(std::span<const uintptr_t> pointers)
+        : pointers(pointers),
+          // Keep the load factor under a half, so probe sequences stay short
+          table(std::bit_ceil((pointers.size() * 2) + 1), Graph::INVALID_ID),
+          shift(std::numeric_limits<uint64_t>::digits - std::countr_zero(this->table.size())) {
+        auto mask = this->table.size() - 1;
+        for (object_id id = 0; id < pointers.size(); id++) {
+            auto slot = this->hash(pointers[id]);
+            while (this->table[slot] != Graph::INVALID_ID) {
+                slot = (slot + 1) & mask;
+            }
+            this->table[slot] = id;
+        }
+    }
+
+    /**
+     * @brief Looks up the id of a pointer.
+     *
+     * @param ptr The pointer to look up.
+     * @return The pointer's id, or INVALID_ID if it isn't in the index.
+     */
+    [[nodiscard]] object_id find(uintptr_t ptr) const {
+        auto mask = this->table.size() - 1;
+        for (auto slot = this->hash(ptr); this->table[slot] != Graph::INVALID_ID;
+             slot = (slot + 1) & mask) {
+            auto id = this->table[slot];
+            if (this->pointers[id] == ptr) {
+                return id;
+            }
+        }
+        return Graph::INVALID_ID;
+    }
+
+   private:
+    std::span<const uintptr_t> pointers;
+    std::vector<object_id> table;
+    int shift;
+
+    /**
+     * @brief Hashes a pointer into a table slot.
+     * @note Objects are allocated close together, so uses fibonacci hashing to spread out the low
+     *       bits, and then takes the top bits of the result.
+     *
+     * @param ptr The pointer to hash.
+     * @return The slot to start probing at.
+     */
+    [[nodiscard]] size_t hash(uintptr_t ptr) const {
+        const constexpr uint64_t multiplier = 0x9E3779B97F4A7C15;
+        // Shifting a 64-bit value by 64 is undefined, so do it in two steps for single slot tables
+        return static_cast<size_t>(((static_cast<uint64_t>(ptr) * multiplier) >> 1)
+                                   >> (this->shift - 1));
+    }
+};
+
+}  // namespace
+
+void GraphShard::add_object(uintptr_t ptr,
+                            std::string_view name,
+                            uint32_t gobjects_idx,
+                            uintptr_t cls,
+                            uintptr_t outer,
+                            uint8_t flags,
+                            uint32_t shallow_size) {
+    this->objects.push_back({.ptr = ptr,
+                             .cls = cls,
+                             .outer = outer,
+                             .flags = flags,
+                             .gobjects_idx = gobjects_idx,
+                             .shallow_size = shallow_size,
+                             .name_start = this->names.size(),
+                             .name_size = name.size()});
+    this->names.append(name);
+}
+
+Graph::Graph(std::vector<GraphShard>&& shards, size_t thread_count, const Graph* previous) {
+    // Gather up all the objects whose refs we're copying over
+    std::vector<uintptr_t> unchanged_objects{};
+    if (previous != nullptr) {
+        for (auto& shard : shards) {
+            unchanged_objects.insert(unchanged_objects.end(), shard.unchanged_objects.begin(),
+                                     shard.unchanged_objects.end());
+            shard.unchanged_objects = {};
+        }
+        radix_sort(unchanged_objects, thread_count);
+    }
+
+    // Assign ids by sorting every address we've seen
+    for (const auto& shard : shards) {
+        for (const auto& obj : shard.objects) {
+            this->pointers.push_back(obj.ptr);
+        }
+        // Each object's refs are all found together, so skip over the repeated froms early
+        uintptr_t last_from = NO_POINTER;
+        for (const auto& [from, to] : shard.refs) {
+            if (from != last_from) {
+                this->pointers.push_back(from);
+                last_from = from;
+            }
+            this->pointers.push_back(to);
+        }
+    }
+    for (auto ptr : unchanged_objects) {
+        this->pointers.push_back(ptr);
+        auto old_id = previous->find_pointer(ptr);
+        if (old_id != INVALID_ID) {
+            for (auto to : previous->refs_from(old_id)) {
+                this->pointers.push_back(previous->pointer(to));
+            }
+        }
+    }
+    sort_unique(this->pointers, thread_count);
+    this->pointers.shrink_to_fit();
+
+    auto num_objects = this->pointers.size();
+    const PointerIndex index{this->pointers};
+
+    // Flatten the names, indexes, classes, outers, flags, and sizes into id order
+    std::vector<std::string_view> names(num_objects);
+    this->gobjects_indexes.assign(num_objects, UNKNOWN_GOBJECTS_IDX);
+    this->class_ids.assign(num_objects, INVALID_ID);
+    this->outer_ids.assign(num_objects, INVALID_ID);
+    this->object_flags.assign(num_objects, 0);
+    this->shallow_sizes.assign(num_objects, 0);
+    size_t total_name_size = 0;
+    for (const auto& shard : shards) {
+        for (const auto& obj : shard.objects) {
+            auto id = index.find(obj.ptr);
+            total_name_size += obj.name_size;
+            this->gobjects_indexes[id] = obj.gobjects_idx;
+            this->object_flags[id] = obj.flags;
+            this->shallow_sizes[id] = obj.shallow_size;
+            if (obj.cls != 0) {
+                this->class_ids[id] = index.find(obj.cls);
+            }
+            if (obj.outer != 0) {
+                this->outer_ids[id] = index.find(obj.outer);
+            }
+            names[id] = std::string_view{shard.names}.substr(obj.name_start, obj.name_size);
+        }
+    }
+
+    this->name_data.reserve(total_name_size);
+    this->name_offsets.reserve(num_objects + 1);
+    for (const auto& name : names) {
+        this->name_offsets.push_back(this->name_data.size());
+        this->name_data.append(name);
+    }
+    this->name_offsets.push_back(this->name_data.size());
+    names = {};
+    for (auto& shard : shards) {
+        shard.objects = {};
+        shard.names = {};
+    }
+    this->build_name_table();
+
+    // Convert refs to ids, packed so we can sort + dedup in one go
+    std::vector<uint64_t> packed_refs{};
+    packed_refs.reserve(std::transform_reduce(shards.begin(), shards.end(), size_t{0}, std::plus{},
+                                              [](auto& shard) { return shard.refs.size(); }));
+    for (auto& shard : shards) {
+        uintptr_t last_from = NO_POINTER;
+        uint64_t from_id = 0;
+        for (const auto& [from, to] : shard.refs) {
+            if (from != last_from) {
+                from_id = static_cast<uint64_t>(index.find(from)) << 32;
+                last_from = from;
+            }
+            packed_refs.push_back(from_id | index.find(to));
+        }
+        shard.refs = {};
+    }
+    sort_unique(packed_refs, thread_count);
+
+    if (!unchanged_objects.empty()) {
+        // Both graphs assign ids in address order, so mapping the old refs across keeps them
+        // sorted. Since an object's refs either all come from the previous graph, or were all
+        // rescanned, the two lists never overlap, and we can just merge them.
+        std::vector<uint64_t> copied_refs{};
+        for (auto ptr : unchanged_objects) {
+            auto old_id = previous->find_pointer(ptr);
+            if (old_id == INVALID_ID) {
+                continue;
+            }
+            auto from = static_cast<uint64_t>(index.find(ptr)) << 32;
+            for (auto to : previous->refs_from(old_id)) {
+                copied_refs.push_back(from | index.find(previous->pointer(to)));
+            }
+        }
+        unchanged_objects = {};
+
+        std::vector<uint64_t> merged_refs(packed_refs.size() + copied_refs.size());
+        std::ranges::merge(packed_refs, copied_refs, merged_refs.begin());
+        packed_refs = std::move(merged_refs);
+    }
+
+    auto num_refs = packed_refs.size();
+
+    // Since we sorted by from id, the forward direction is already in the right order
+    std::vector<object_id> sources(num_refs);
+    this->from_refs.resize(num_refs);
+    for (size_t i = 0; i < num_refs; i++) {
+        sources[i] = static_cast<object_id>(packed_refs[i] >> 32);
+        this->from_refs[i] = static_cast<object_id>(packed_refs[i]);
+    }
+    this->from_offsets.resize(num_objects + 1);
+    fill_offsets(this->from_offsets, sources);
+
+    this->build_reverse_refs();
+}
+
+Graph::Graph(std::vector<uintptr_t>&& pointers,
+             std::vector<uint32_t>&& gobjects_indexes,
+             std::vector<object_id>&& class_ids,
+             std::vector<object_id>&& outer_ids,
+             std::vector<uint8_t>&& flags,
+             std::vector<uint32_t>&& shallow_sizes,
+             std::string&& name_data,
+             std::vector<size_t>&& name_offsets,
+             std::vector<size_t>&& from_offsets,
+             std::vector<object_id>&& from_refs)
+    : pointers(std::move(pointers)),
+      gobjects_indexes(std::move(gobjects_indexes)),
+      class_ids(std::move(class_ids)),
+      outer_ids(std::move(outer_ids)),
+      object_flags(std::move(flags)),
+      shallow_sizes(std::move(shallow_sizes)),
+      name_data(std::move(name_data)),
+      name_offsets(std::move(name_offsets)),
+      from_offsets(std::move(from_offsets)),
+      from_refs(std::move(from_refs)) {
+    this->build_name_table();
+    this->build_reverse_refs();
+}
+
+size_t Graph::num_objects(void) const {
+    return this->pointers.size();
+}
+
+size_t Graph::num_refs(void) const {
+    return this->from_refs.size();
+}
+
+size_t Graph::memory_usage(void) const {
+    auto vector_size = [](const auto& vec) {
+        return vec.capacity() * sizeof(typename std::remove_cvref_t<decltype(vec)>::value_type);
+    };
+    return vector_size(this->pointers) + vector_size(this->gobjects_indexes)
+           + vector_size(this->class_ids) + vector_size(this->outer_ids)
+           + vector_size(this->object_flags) + vector_size(this->shallow_sizes)
+           + this->name_data.capacity() + vector_size(this->name_offsets)
+           + vector_size(this->name_table) + vector_size(this->from_offsets)
+           + vector_size(this->from_refs) + vector_size(this->to_offsets)
+           + vector_size(this->to_refs);
+}
+
+uintptr_t Graph::pointer(object_id id) const {
+    return this->pointers[id];
+}
+
+uint32_t Graph::gobjects_index(object_id id) const {
+    return this->gobjects_indexes[id];
+}
+
+object_id Graph::class_id(object_id id) const {
+    return this->class_ids[id];
+}
+
+object_id Graph::outer_id(object_id id) const {
+    return this->outer_ids[id];
+}
+
+object_id Graph::package_id(object_id id) const {
+    // Outer chains should never loop, but this was read out of live memory, so don't trust it
+    for (size_t depth = 0; depth < this->num_objects(); depth++) {
+        auto outer = this->outer_ids[id];
+        if (outer == INVALID_ID) {
+            break;
+        }
+        id = outer;
+    }
+    return id;
+}
+
+uint8_t Graph::flags(object_id id) const {
+    return this->object_flags[id];
+}
+
+uint32_t Graph::shallow_size(object_id id) const {
+    return this->shallow_sizes[id];
+}
+
+std::string_view Graph::name(object_id id) const {
+    return std::string_view{this->name_data}.substr(
+        this->name_offsets[id], this->name_offsets[id + 1] - this->name_offsets[id]);
+}
+
+std::span<const object_id> Graph::refs_from(object_id id) const {
+    return std::span{this->from_refs}.subspan(this->from_offsets[id],
+                                              this->from_offsets[id + 1] - this->from_offsets[id]);
+}
+
+std::span<const object_id> Graph::refs_to(object_id id) const {
+    return std::span{this->to_refs}.subspan(this->to_offsets[id],
+                                            this->to_offsets[id + 1] - this->to_offsets[id]);
+}
+
+object_id Graph::find_pointer(uintptr_t ptr) const {
+    auto iter = std::ranges::lower_bound(this->pointers, ptr);
+    if (iter == this->pointers.end() || *iter != ptr) {
+        return INVALID_ID;
+    }
+    return static_cast<object_id>(iter - this->pointers.begin());
+}
+
+void Graph::build_reverse_refs(void) {
+    // The reverse direction needs a counting sort by to id. Iterating in from order means each
+    // object's referrers end up sorted too.
+    this->to_offsets.assign(this->num_objects() + 1, 0);
+    for (auto to : this->from_refs) {
+        this->to_offsets[to + 1]++;
+    }
+    std::partial_sum(this->to_offsets.begin(), this->to_offsets.end(), this->to_offsets.begin());
+
+    this->to_refs.resize(this->num_refs());
+    auto insert_pos = this->to_offsets;
+    for (object_id from = 0; from < this->num_objects(); from++) {
+        for (auto to : this->refs_from(from)) {
+            this->to_refs[insert_pos[to]++] = from;
+        }
+    }
+}
+
+void Graph::build_name_table(void) {
+    // Keep the load factor under a half, so probe sequences stay short
+    this->name_table.assign(std::bit_ceil((this->num_objects() * 2) + 1), INVALID_ID);
+    auto mask = this->name_table.size() - 1;
+
+    // Insert in id order, so on duplicate names we find the lowest id first
+    for (object_id id = 0; id < this->num_objects(); id++) {
+        auto name = this->name(id);
+        if (name.empty()) {
+            continue;
+        }
+        auto slot = std::hash<std::string_view>{}(name) & mask;
+        while (this->name_table[slot] != INVALID_ID) {
+            slot = (slot + 1) & mask;
+        }
+        this->name_table[slot] = id;
+    }
+}
+
+object_id Graph::find_name(std::string_view name) const {
+    if (name.empty()) {
+        return INVALID_ID;
+    }
+
+    auto mask = this->name_table.size() - 1;
+    for (auto slot = std::hash<std::string_view>{}(name) & mask;
+         this->name_table[slot] != INVALID_ID; slot = (slot + 1) & mask) {
+        auto id = this->name_table[slot];
+        if (this->name(id) == name) {
+            return id;
+        }
+    }
+    return INVALID_ID;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,265 @@
+#ifndef REFS_GRAPH_H
+#define REFS_GRAPH_H
+
+#include "pch.h"
+
+namespace live_object_explorer::refs::internal {
+
+// Dense ids, indexing into all of the graph's arrays
+using object_id = uint32_t;
+
+// Used in place of a GObjects index for objects we never saw in GObjects
+constexpr uint32_t UNKNOWN_GOBJECTS_IDX = std::numeric_limits<uint32_t>::max();
+
+// Set on objects the engine keeps alive itself, no matter what references them
+constexpr uint8_t OBJECT_FLAG_ROOT = 1 << 0;
+// Set on UFields, whose refs all come from native fields (Next, Children, SuperField, etc.)
+constexpr uint8_t OBJECT_FLAG_FIELD = 1 << 1;
+// Set on class default objects, which their class keeps alive
+constexpr uint8_t OBJECT_FLAG_DEFAULT = 1 << 2;
+// Set on engine and world objects, which the engine holds global pointers to
+constexpr uint8_t OBJECT_FLAG_SINGLETON = 1 << 3;
+
+/**
+ * @brief The raw results gathered by a single snapshot thread, ready to be built into a graph.
+ */
+struct GraphShard {
+    struct Object {
+        uintptr_t ptr;
+        // The object's class and outer, or 0 if unknown
+        uintptr_t cls;
+        uintptr_t outer;
+        uint8_t flags;
+        uint32_t gobjects_idx;
+        uint32_t shallow_size;
+        // The range of the object's name within `names`
+        size_t name_start;
+        size_t name_size;
+    };
+
+    std::vector<Object> objects;
+    // All object names concatenated together, to avoid allocating each one
+    std::string names;
+    std::vector<std::pair<uintptr_t, uintptr_t>> refs;
+    // Objects which weren't rescanned, whose refs should be copied from the previous graph
+    std::vector<uintptr_t> unchanged_objects;
+
+    /**
+     * @brief Adds an object to this shard.
+     *
+     * @param ptr The object's address.
+     * @param name The object's name.
+     * @param gobjects_idx The object's index in GObjects.
+     * @param cls The address of the object's class, or 0 if unknown.
+     * @param outer The address of the object's outer, or 0 if unknown.
+     * @param flags The object's flags.
+     * @param shallow_size How much memory the object owns directly, in bytes.
+     */
+    void add_object(uintptr_t ptr,
+                    std::string_view name,
+                    uint32_t gobjects_idx = UNKNOWN_GOBJECTS_IDX,
+                    uintptr_t cls = 0,
+                    uintptr_t outer = 0,
+                    uint8_t flags = 0,
+                    uint32_t shallow_size = 0);
+};
+
+/**
+ * @brief An immutable snapshot of which objects reference which others.
+ * @note Stored as a pair of compressed sparse row adjacency arrays, one for each direction, so that
+ *       looking up refs either way is just a slice.
+ */
+class Graph {
+   public:
+    static constexpr object_id INVALID_ID = std::numeric_limits<object_id>::max();
+
+    /**
+     * @brief Builds a new graph.
+     *
+     * @param shards The shards to build the graph out of. Moved from.
+     * @param thread_count How many threads to use while sorting.
+     * @param previous The previous graph, to copy the refs of any unchanged objects from. May be
+     *                 null if no shards have unchanged objects.
+     */
+    Graph(std::vector<GraphShard>&& shards, size_t thread_count, const Graph* previous = nullptr);
+
+    /**
+     * @brief Rebuilds a graph out of the arrays of one which was already built, such as one read
+     *        back off disk.
+     * @note Does not validate the arrays, the caller must make sure they're consistent. Pointers
+     *       must be sorted, and each object's refs must be sorted.
+     *
+     * @param pointers The address of each object.
+     * @param gobjects_indexes The GObjects index of each object.
+     * @param class_ids The class id of each object.
+     * @param outer_ids The outer id of each object.
+     * @param flags The flags of each object.
+     * @param shallow_sizes The shallow size of each object.
+     * @param name_data All names concatenated together.
+     * @param name_offsets The offset of each object's name, plus one past the end.
+     * @param from_offsets The forward CSR offsets.
+     * @param from_refs The forward CSR refs.
+     */
+    Graph(std::vector<uintptr_t>&& pointers,
+          std::vector<uint32_t>&& gobjects_indexes,
+          std::vector<object_id>&& class_ids,
+          std::vector<object_id>&& outer_ids,
+          std::vector<uint8_t>&& flags,
+          std::vector<uint32_t>&& shallow_sizes,
+          std::string&& name_data,
+          std::vector<size_t>&& name_offsets,
+          std::vector<size_t>&& from_offsets,
+          std::vector<object_id>&& from_refs);
+
+    /**
+     * @brief Gets the total amount of objects, or references, stored in this graph.
+     *
+     * @return The number of objects/refs.
+     */
+    [[nodiscard]] size_t num_objects(void) const;
+    [[nodiscard]] size_t num_refs(void) const;
+
+    /**
+     * @brief Gets how much memory this graph is using.
+     *
+     * @return The size of all the graph's arrays, in bytes.
+     */
+    [[nodiscard]] size_t memory_usage(void) const;
+
+    /**
+     * @brief Gets the address an object was located at at the time of the snapshot.
+     *
+     * @param id The object's id.
+     * @return The object's address.
+     */
+    [[nodiscard]] uintptr_t pointer(object_id id) const;
+
+    /**
+     * @brief Gets the index in GObjects an object was located at at the time of the snapshot.
+     * @note Much quicker to look an object back up by than it's name, but the slot may since have
+     *       been reused by another object, so the caller must validate whatever it finds there.
+     *
+     * @param id The object's id.
+     * @return The object's GObjects index, or UNKNOWN_GOBJECTS_IDX if we never learnt it.
+     */
+    [[nodiscard]] uint32_t gobjects_index(object_id id) const;
+
+    /**
+     * @brief Gets an object's class.
+     *
+     * @param id The object's id.
+     * @return The class's id, or INVALID_ID if we never learnt it.
+     */
+    [[nodiscard]] object_id class_id(object_id id) const;
+
+    /**
+     * @brief Gets an object's outer.
+     *
+     * @param id The object's id.
+     * @return The outer's id, or INVALID_ID if it has none, or we never learnt it.
+     */
+    [[nodiscard]] object_id outer_id(object_id id) const;
+
+    /**
+     * @brief Gets the package an object is in, by following it's outers to the outermost one.
+     *
+     * @param id The object's id.
+     * @return The package's id. If the object has no outer, it's own id.
+     */
+    [[nodiscard]] object_id package_id(object_id id) const;
+
+    /**
+     * @brief Gets an object's flags.
+     *
+     * @param id The object's id.
+     * @return The object's flags, a combination of the `OBJECT_FLAG_*` constants.
+     */
+    [[nodiscard]] uint8_t flags(object_id id) const;
+
+    /**
+     * @brief Gets how much memory an object owns directly, not counting anything it references.
+     * @note Only includes the object itself and the buffers of it's arrays, anything else it
+     *       allocated is invisible to us.
+     *
+     * @param id The object's id.
+     * @return The object's shallow size, in bytes. Zero if we never learnt it.
+     */
+    [[nodiscard]] uint32_t shallow_size(object_id id) const;
+
+    /**
+     * @brief Gets an object's path name.
+     *
+     * @param id The object's id.
+     * @return The object's name. Empty if we never learnt it.
+     */
+    [[nodiscard]] std::string_view name(object_id id) const;
+
+    /**
+     * @brief Gets all objects the given one references.
+     *
+     * @param id The object's id.
+     * @return A sorted span of referenced object ids.
+     */
+    [[nodiscard]] std::span<const object_id> refs_from(object_id id) const;
+
+    /**
+     * @brief Gets all objects which reference the given one.
+     *
+     * @param id The object's id.
+     * @return A sorted span of referencing object ids.
+     */
+    [[nodiscard]] std::span<const object_id> refs_to(object_id id) const;
+
+    /**
+     * @brief Looks up an object's id by it's address.
+     *
+     * @param ptr The object's address.
+     * @return The object's id, or INVALID_ID if it doesn't exist.
+     */
+    [[nodiscard]] object_id find_pointer(uintptr_t ptr) const;
+
+    /**
+     * @brief Looks up an object's id by it's path name.
+     *
+     * @param name The object's name.
+     * @return The object's id, or INVALID_ID if it doesn't exist.
+     */
+    [[nodiscard]] object_id find_name(std::string_view name) const;
+
+   private:
+    // Sorted, so an object's id is it's index in this array
+    std::vector<uintptr_t> pointers;
+    std::vector<uint32_t> gobjects_indexes;
+    std::vector<object_id> class_ids;
+    std::vector<object_id> outer_ids;
+    std::vector<uint8_t> object_flags;
+    std::vector<uint32_t> shallow_sizes;
+
+    // All names concatenated together, and the offset of each id's name, plus one past the end
+    std::string name_data;
+    std::vector<size_t> name_offsets;
+
+    // An open addressing hash table of ids, keyed by name, so exact name lookups don't need to scan
+    // every object. Size is a power of two, empty slots hold INVALID_ID.
+    std::vector<object_id> name_table;
+
+    // CSR adjacency - the refs of object `id` are `[offsets[id], offsets[id + 1])`
+    std::vector<size_t> from_offsets;
+    std::vector<object_id> from_refs;
+    std::vector<size_t> to_offsets;
+    std::vector<object_id> to_refs;
+
+    /**
+     * @brief Fills the reverse CSR arrays, after the forward ones have been built.
+     */
+    void build_reverse_refs(void);
+
+    /**
+     * @brief Fills the name hash table, after all names have been added.
+     */
+    void build_name_table(void);
+};
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_GRAPH_H */
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "refs/groups.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+object_id group_key(const Graph& graph, object_id id, GroupKind kind) {
+    switch (kind) {
+        case GroupKind::CLASS:
+            return graph.class_id(id);
+        case GroupKind::PACKAGE:
+            return graph.package_id(id);
+    }
+    return Graph::INVALID_ID;
+}
+
+std::vector<ObjectGroup> group_objects(const Graph& graph,
+                                       std::span<const object_id> ids,
+                                       GroupKind kind) {
+    // There are usually far fewer groups than objects, so a map stays small
+    std::unordered_map<object_id, size_t> counts{};
+    for (auto id : ids) {
+        counts[group_key(graph, id, kind)]++;
+    }
+
+    std::vector<ObjectGroup> groups{};
+    groups.reserve(counts.size());
+    for (const auto& [key, count] : counts) {
+        groups.push_back({.key = key, .count = count});
+    }
+    // Break ties by key, so the order's stable between runs
+    std::ranges::sort(groups, [](const ObjectGroup& lhs, const ObjectGroup& rhs) {
+        return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.key < rhs.key;
+    });
+    return groups;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,51 @@
+#ifndef REFS_GROUPS_H
+#define REFS_GROUPS_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief What to group a set of objects by.
+ */
+enum class GroupKind : uint8_t {
+    CLASS,
+    PACKAGE,
+};
+
+/**
+ * @brief A group of objects sharing the same class or package.
+ */
+struct ObjectGroup {
+    // The id of the shared class/package, or INVALID_ID for objects where we never learnt it
+    object_id key;
+    size_t count;
+};
+
+/**
+ * @brief Gets the key an object would be grouped under.
+ *
+ * @param graph The graph the object is in.
+ * @param id The object's id.
+ * @param kind What to group by.
+ * @return The group key.
+ */
+[[nodiscard]] object_id group_key(const Graph& graph, object_id id, GroupKind kind);
+
+/**
+ * @brief Counts how many of the given objects fall into each group.
+ * @note Only looks at the dense per object arrays, doesn't touch any names.
+ *
+ * @param graph The graph the objects are in.
+ * @param ids The objects to group.
+ * @param kind What to group by.
+ * @return The groups, largest first.
+ */
+[[nodiscard]] std::vector<ObjectGroup> group_objects(const Graph& graph,
+                                                     std::span<const object_id> ids,
+                                                     GroupKind kind);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_GROUPS_H */
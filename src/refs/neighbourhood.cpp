@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "refs/neighbourhood.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+// How many objects to expand between checking if we've been cancelled
+constexpr size_t STOP_CHECK_INTERVAL = 0x400;
+
+}  // namespace
+
+size_t Neighbourhood::max_depth(void) const {
+    return this->depth_offsets.empty() ? 0 : this->depth_offsets.size() - 1;
+}
+
+std::span<const object_id> Neighbourhood::at_depth(size_t depth) const {
+    auto start = this->depth_offsets[depth - 1];
+    return std::span{this->ids}.subspan(start, this->depth_offsets[depth] - start);
+}
+
+Neighbourhood find_neighbourhood(const Graph& graph,
+                                 object_id start,
+                                 RefDirection direction,
+                                 size_t max_depth,
+                                 std::span<const object_id> class_filter,
+                                 size_t max_results,
+                                 const std::stop_token& stop_token) {
+    Neighbourhood found{.ids = {}, .depth_offsets = {0}, .truncated = false};
+
+    std::vector<bool> visited(graph.num_objects(), false);
+    visited[start] = true;
+
+    std::vector<object_id> level{start};
+    std::vector<object_id> next_level{};
+    size_t expanded = 0;
+
+    for (size_t depth = 1; depth <= max_depth && !level.empty() && !found.truncated; depth++) {
+        next_level.clear();
+
+        for (auto id : level) {
+            if (++expanded % STOP_CHECK_INTERVAL == 0 && stop_token.stop_requested()) {
+                found.truncated = true;
+                break;
+            }
+
+            auto refs = direction == RefDirection::TO ? graph.refs_to(id) : graph.refs_from(id);
+            for (auto ref : refs) {
+                if (visited[ref]) {
+                    continue;
+                }
+                visited[ref] = true;
+                next_level.push_back(ref);
+
+                if (!class_filter.empty()
+                    && !std::ranges::binary_search(class_filter, graph.class_id(ref))) {
+                    continue;
+                }
+                if (found.ids.size() >= max_results) {
+                    found.truncated = true;
+                    break;
+                }
+                found.ids.push_back(ref);
+            }
+            if (found.truncated) {
+                break;
+            }
+        }
+
+        found.depth_offsets.push_back(found.ids.size());
+        std::swap(level, next_level);
+    }
+
+    // With a class filter, the last few depths may not have found anything - trim them off, so the
+    // max depth is the deepest we actually found something at
+    while (found.depth_offsets.size() > 1
+           && found.depth_offsets.back() == found.depth_offsets[found.depth_offsets.size() - 2]) {
+        found.depth_offsets.pop_back();
+    }
+    return found;
+}
+
+}  // namespace live_object_explorer::refs::internal
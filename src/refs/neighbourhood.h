@@ -0,0 +1,72 @@
+#ifndef REFS_NEIGHBOURHOOD_H
+#define REFS_NEIGHBOURHOOD_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Which way to follow refs.
+ */
+enum class RefDirection : uint8_t {
+    // From each object to the objects referencing it
+    TO,
+    // From each object to the objects it references
+    FROM,
+};
+
+/**
+ * @brief The objects within some number of refs of another object, grouped by their distance.
+ */
+struct Neighbourhood {
+    // The objects found at each depth, grouped together, in the order they were found
+    std::vector<object_id> ids;
+    // The offset of each depth's objects within the ids, plus one past the end. Depth 1 starts at
+    // index 0.
+    std::vector<size_t> depth_offsets;
+    // True if we stopped early, due to hitting the result limit or being cancelled
+    bool truncated;
+
+    /**
+     * @brief Gets the deepest depth we found any objects at.
+     *
+     * @return The max depth.
+     */
+    [[nodiscard]] size_t max_depth(void) const;
+
+    /**
+     * @brief Gets the objects found at a given depth.
+     *
+     * @param depth The depth, starting at 1.
+     * @return The objects' ids.
+     */
+    [[nodiscard]] std::span<const object_id> at_depth(size_t depth) const;
+};
+
+/**
+ * @brief Finds all objects within a given number of refs of an object.
+ * @note Searches one depth at a time, so every object is reported at it's shortest distance.
+ * @note The class filter only limits which objects are reported, the search still follows refs
+ *       through objects of any class.
+ *
+ * @param graph The graph to search.
+ * @param start The object to start from. Not included in the results.
+ * @param direction Which way to follow refs.
+ * @param max_depth The most refs to follow.
+ * @param class_filter If not empty, the sorted ids of the classes to report objects of.
+ * @param max_results The most objects to report.
+ * @param stop_token A stop token, to cancel the search early.
+ * @return The objects found.
+ */
+[[nodiscard]] Neighbourhood find_neighbourhood(const Graph& graph,
+                                               object_id start,
+                                               RefDirection direction,
+                                               size_t max_depth,
+                                               std::span<const object_id> class_filter,
+                                               size_t max_results,
+                                               const std::stop_token& stop_token);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_NEIGHBOURHOOD_H */
@@ -0,0 +1,220 @@
+#include "pch.h"
+#include "refs/parallel_for.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+/**
+ * @brief A set of thread indexes, shared between the thread which submitted them and any free
+ *        workers.
+ */
+struct TaskSet {
+    const std::function<void(size_t thread_idx)>* func;
+    size_t count;
+
+    // All guarded by the pool mutex
+    size_t next_idx = 0;
+    size_t active = 0;
+    std::exception_ptr exception{};
+};
+
+/**
+ * @brief A pool of long lived worker threads.
+ * @note Creating threads for every pass used to cost a noticeable chunk of a snapshot, and meant a
+ *       failure to create one part way through took the whole game down. The workers instead get
+ *       started once, and then sit waiting for task sets.
+ */
+class WorkerPool {
+   public:
+    WorkerPool(void) = default;
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    ~WorkerPool() {
+        {
+            const std::scoped_lock lock{this->mutex};
+            this->exiting = true;
+        }
+        this->work_available.notify_all();
+        for (auto& worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Makes sure the pool has at least the given number of workers.
+     *
+     * @param worker_count The number of workers.
+     */
+    void reserve(size_t worker_count) {
+        std::unique_lock lock{this->mutex};
+        if (this->released) {
+            return;
+        }
+        while (this->workers.size() < worker_count) {
+            try {
+                this->workers.emplace_back(&WorkerPool::run_worker, this);
+            } catch (const std::system_error& ex) {
+                LOG(ERROR, "Failed to start worker thread: {}", ex.what());
+                break;
+            }
+        }
+
+        // Starting a thread needs the loader lock. Wait for them all to get going now, so we never
+        // get left with one still waiting to start when we get unloaded.
+        this->worker_started.wait(
+            lock, [this]() { return this->num_started == this->workers.size(); });
+    }
+
+    /**
+     * @brief Detaches all workers, leaving them parked.
+     *
+     * @param wait_for_idle If true, waits for any running task sets to finish first.
+     */
+    void release(bool wait_for_idle) {
+        std::unique_lock lock{this->mutex};
+        this->released = true;
+        if (wait_for_idle) {
+            this->task_finished.wait(lock, [this]() { return this->num_running_sets == 0; });
+        }
+        for (auto& worker : this->workers) {
+            worker.detach();
+        }
+        this->workers.clear();
+    }
+
+    /**
+     * @brief Runs a task set, on the calling thread and any free workers, until all indexes are
+     *        finished.
+     *
+     * @param tasks The task set to run.
+     */
+    void run(TaskSet& tasks) {
+        std::unique_lock lock{this->mutex};
+        this->num_running_sets++;
+        if (tasks.count > 1 && !this->workers.empty()) {
+            this->open_sets.push_back(&tasks);
+            this->work_available.notify_all();
+        }
+
+        // Never wait on a worker to pick up an index, just run whatever's left ourselves, so we
+        // still finish even if all the workers are busy
+        this->run_tasks(lock, tasks);
+        this->task_finished.wait(lock, [&tasks]() { return tasks.active == 0; });
+        if (--this->num_running_sets == 0) {
+            this->task_finished.notify_all();
+        }
+
+        if (tasks.exception != nullptr) {
+            std::rethrow_exception(tasks.exception);
+        }
+    }
+
+   private:
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable task_finished;
+    std::condition_variable worker_started;
+
+    // All guarded by the mutex
+    std::vector<std::thread> workers;
+    size_t num_started = 0;
+    size_t num_running_sets = 0;
+    // Task sets which still have indexes left to claim
+    std::vector<TaskSet*> open_sets;
+    bool released = false;
+    bool exiting = false;
+
+    /**
+     * @brief Claims and runs indexes from a task set until there are none left.
+     *
+     * @param lock The lock on the pool mutex. Must be held, is held again on return.
+     * @param tasks The task set to run.
+     */
+    void run_tasks(std::unique_lock<std::mutex>& lock, TaskSet& tasks) {
+        while (tasks.next_idx < tasks.count) {
+            auto thread_idx = tasks.next_idx++;
+            if (tasks.next_idx == tasks.count) {
+                std::erase(this->open_sets, &tasks);
+            }
+            tasks.active++;
+            lock.unlock();
+
+            std::exception_ptr exception{};
+            try {
+                (*tasks.func)(thread_idx);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+
+            lock.lock();
+            if (exception != nullptr && tasks.exception == nullptr) {
+                tasks.exception = exception;
+            }
+            if (--tasks.active == 0 && tasks.next_idx == tasks.count) {
+                this->task_finished.notify_all();
+            }
+        }
+    }
+
+    /**
+     * @brief The main loop of each worker thread.
+     */
+    void run_worker(void) {
+        std::unique_lock lock{this->mutex};
+        this->num_started++;
+        this->worker_started.notify_all();
+
+        while (true) {
+            this->work_available.wait(
+                lock, [this]() { return this->exiting || !this->open_sets.empty(); });
+            if (this->exiting) {
+                return;
+            }
+            this->run_tasks(lock, *this->open_sets.front());
+        }
+    }
+};
+
+WorkerPool pool{};
+
+}  // namespace
+
+ChunkCursor::ChunkCursor(size_t count) : count(count) {}
+
+bool ChunkCursor::next(size_t& start_idx, size_t& end_idx) {
+    start_idx = this->cursor.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+    if (start_idx >= this->count) {
+        return false;
+    }
+    end_idx = std::min(start_idx + CHUNK_SIZE, this->count);
+    return true;
+}
+
+void run_on_workers(size_t thread_count, const std::function<void(size_t thread_idx)>& func) {
+    TaskSet tasks{.func = &func, .count = thread_count};
+    pool.run(tasks);
+}
+
+void parallel_for(size_t count,
+                  size_t thread_count,
+                  const std::function<void(size_t thread_idx, ChunkCursor& cursor)>& func) {
+    ChunkCursor cursor{count};
+    run_on_workers(thread_count,
+                   [&func, &cursor](size_t thread_idx) { func(thread_idx, cursor); });
+}
+
+void reserve_workers(size_t thread_count) {
+    // The calling thread always takes part, so we need one less worker
+    pool.reserve(std::max<size_t>(thread_count, 1) - 1);
+}
+
+void release_workers(bool wait_for_idle) {
+    pool.release(wait_for_idle);
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,91 @@
+#ifndef REFS_PARALLEL_FOR_H
+#define REFS_PARALLEL_FOR_H
+
+#include "pch.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Hands out chunks of a range of indexes to multiple threads.
+ * @note Objects vary wildly in how long they take to process, so rather than giving each thread an
+ *       equal share up front, threads keep pulling small chunks until there are none left. A
+ *       thread which got a run of cheap objects just ends up taking more chunks.
+ */
+class ChunkCursor {
+   public:
+    /**
+     * @brief Creates a new cursor.
+     *
+     * @param count The total number of indexes.
+     */
+    ChunkCursor(size_t count);
+
+    /**
+     * @brief Claims the next chunk.
+     *
+     * @param start_idx Set to the first index of the chunk.
+     * @param end_idx Set to one past the last index of the chunk.
+     * @return True if a chunk was claimed, false if there are none left.
+     */
+    bool next(size_t& start_idx, size_t& end_idx);
+
+   private:
+    // Small enough to even out the load, large enough the cursor isn't constantly contended
+    static constexpr size_t CHUNK_SIZE = 0x400;
+
+    std::atomic<size_t> cursor = 0;
+    size_t count;
+};
+
+/**
+ * @brief Runs a function once per thread index, spread between the calling thread and the worker
+ *        pool.
+ * @note Every index is run exactly once, but if there aren't enough free workers, the calling
+ *       thread runs the leftover indexes itself, one after the other. Indexes must not wait on
+ *       each other.
+ * @note Never starts any threads itself, call `reserve_workers` beforehand to make sure there are
+ *       enough workers.
+ * @note If any index throws, the first exception is rethrown after all indexes have finished.
+ *
+ * @param thread_count How many thread indexes to run.
+ * @param func The function to run. Gets passed the thread index.
+ */
+void run_on_workers(size_t thread_count, const std::function<void(size_t thread_idx)>& func);
+
+/**
+ * @brief Runs a function on multiple threads, which share a range of indexes between them.
+ *
+ * @param count The total number of indexes.
+ * @param thread_count How many threads to run.
+ * @param func The function to run. Gets passed the thread's index, and the cursor it should pull
+ *             chunks of indexes from.
+ */
+void parallel_for(size_t count,
+                  size_t thread_count,
+                  const std::function<void(size_t thread_idx, ChunkCursor& cursor)>& func);
+
+/**
+ * @brief Makes sure the worker pool has enough threads to run the given number of thread indexes
+ *        at once, alongside the calling thread.
+ * @note Workers are never stopped, so this only ever grows the pool. If a thread fails to start,
+ *       logs it and carries on with however many we have.
+ * @note Waits for all new workers to start running. Since that needs the loader lock, this must
+ *       not be called from a thread which might be waited on during `DllMain`.
+ *
+ * @param thread_count How many threads we want to run at once, including the calling thread.
+ */
+void reserve_workers(size_t thread_count);
+
+/**
+ * @brief Lets go of all the worker pool's threads, so they don't need joining while the dll's
+ *        being unloaded.
+ * @note The workers are left parked, and never get given any more work. Anything run afterwards
+ *       only runs on the calling thread.
+ *
+ * @param wait_for_idle If true, waits for any work already running on the pool to finish first.
+ */
+void release_workers(bool wait_for_idle);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_PARALLEL_FOR_H */
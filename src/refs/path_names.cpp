@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "refs/path_names.h"
+#include "refs/graph.h"
+
+using namespace unrealsdk::unreal;
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+// The raw layout of a name - an index into the global name table, plus a number suffix
+struct RawFName {
+    int32_t index;
+    int32_t number;
+};
+static_assert(sizeof(RawFName) == sizeof(FName));
+
+}  // namespace
+
+PathNameBuilder::PathNameBuilder(std::span<const ObjectRecord> records, uintptr_t package_class)
+    : records(records), package_class(package_class) {}
+
+size_t PathNameBuilder::find_record(uintptr_t obj) const {
+    auto iter = std::ranges::lower_bound(this->records, obj, {}, &ObjectRecord::obj);
+    if (iter == this->records.end() || iter->obj != obj) {
+        return INVALID_IDX;
+    }
+    return static_cast<size_t>(iter - this->records.begin());
+}
+
+char PathNameBuilder::separator(size_t outer_idx) const {
+    // Subobjects of an object which is directly inside a package use a colon
+    const auto& outer = this->records[outer_idx];
+    if (outer.cls == this->package_class) {
+        return '.';
+    }
+    auto outer_outer_idx = this->find_record(outer.outer);
+    return (outer_outer_idx != INVALID_IDX
+            && this->records[outer_outer_idx].cls == this->package_class)
+               ? ':'
+               : '.';
+}
+
+void PathNameBuilder::append_name(const FName& name, std::string& str) {
+    RawFName raw{};
+    memcpy(&raw, &name, sizeof(raw));
+
+    auto [iter, inserted] = this->base_name_ranges.try_emplace(raw.index);
+    if (inserted) {
+        const FName base_name(raw.index, 0);
+        auto start = this->base_names.size();
+        this->base_names.append(static_cast<std::string>(base_name));
+        iter->second = {start, this->base_names.size() - start};
+    }
+    auto [start, size] = iter->second;
+    str.append(std::string_view{this->base_names}.substr(start, size));
+
+    // Zero means no suffix, otherwise it's one more than the displayed number
+    if (raw.number != 0) {
+        // Enough for the sign and every digit
+        std::array<char, std::numeric_limits<int32_t>::digits10 + 2> buf{};
+        auto result = std::to_chars(buf.data(), buf.data() + buf.size(), raw.number - 1);
+        str.push_back('_');
+        str.append(buf.data(), result.ptr);
+    }
+}
+
+std::optional<std::string_view> PathNameBuilder::outer_path(size_t idx, size_t depth) {
+    auto iter = this->outer_path_ranges.find(idx);
+    if (iter == this->outer_path_ranges.end()) {
+        // Records were copied out of live memory, so the outer chain might loop back to us
+        this->outer_path_ranges.emplace(idx, IN_PROGRESS);
+
+        // Get the prefix first, since building it might append to the same string
+        PathPrefix prefix{.outer_path = {}, .separator = '\0'};
+        auto outer_idx = this->find_record(this->records[idx].outer);
+        if (outer_idx != INVALID_IDX) {
+            auto outer_path =
+                depth < MAX_OUTER_DEPTH ? this->outer_path(outer_idx, depth + 1) : std::nullopt;
+            if (!outer_path.has_value()) {
+                // Building the outer path may have rehashed the map, so need to look up again
+                this->outer_path_ranges.find(idx)->second = BROKEN;
+                return std::nullopt;
+            }
+            prefix = {.outer_path = *outer_path, .separator = this->separator(outer_idx)};
+        }
+
+        auto start = this->outer_paths.size();
+        this->append_path(prefix, idx, this->outer_paths);
+
+        iter = this->outer_path_ranges.find(idx);
+        iter->second = {start, this->outer_paths.size() - start};
+    } else if (iter->second == IN_PROGRESS || iter->second == BROKEN) {
+        return std::nullopt;
+    }
+
+    auto [start, size] = iter->second;
+    return std::string_view{this->outer_paths}.substr(start, size);
+}
+
+PathNameBuilder::PathPrefix PathNameBuilder::path_prefix(size_t idx) {
+    auto outer_idx = this->find_record(this->records[idx].outer);
+    if (outer_idx == INVALID_IDX) {
+        return {.outer_path = {}, .separator = '\0'};
+    }
+    auto outer_path = this->outer_path(outer_idx, 0);
+    if (!outer_path.has_value()) {
+        return {.outer_path = {}, .separator = '\0'};
+    }
+    return {.outer_path = *outer_path, .separator = this->separator(outer_idx)};
+}
+
+void PathNameBuilder::append_path(const PathPrefix& prefix, size_t idx, std::string& str) {
+    if (prefix.separator != '\0') {
+        str.append(prefix.outer_path);
+        str.push_back(prefix.separator);
+    }
+    this->append_name(this->records[idx].name, str);
+}
+
+void PathNameBuilder::add_object(size_t idx, GraphShard& shard) {
+    auto prefix = this->path_prefix(idx);
+    auto start = shard.names.size();
+    this->append_path(prefix, idx, shard.names);
+    shard.objects.push_back({.ptr = this->records[idx].obj,
+                             .cls = this->records[idx].cls,
+                             .outer = this->records[idx].outer,
+                             .flags = this->records[idx].flags,
+                             .gobjects_idx = static_cast<uint32_t>(this->records[idx].gobjects_idx),
+                             .shallow_size = this->records[idx].shallow_size,
+                             .name_start = start,
+                             .name_size = shard.names.size() - start});
+}
+
+}  // namespace live_object_explorer::refs::internal
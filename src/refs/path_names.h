@@ -0,0 +1,136 @@
+#ifndef REFS_PATH_NAMES_H
+#define REFS_PATH_NAMES_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief The raw fields of an object we need to work out it's path name.
+ * @note Copied out while the world is stopped, so that we can build the name after resuming.
+ */
+struct ObjectRecord {
+    uintptr_t obj;
+    uintptr_t outer;
+    uintptr_t cls;
+    unrealsdk::unreal::FName name;
+
+    // Used to detect which objects are unchanged between snapshots
+    size_t gobjects_idx;
+    uint64_t refs_hash;
+
+    // The object's graph flags, and how much memory it owns directly
+    uint8_t flags;
+    uint32_t shallow_size;
+};
+
+/**
+ * @brief Builds object path names from the records copied during a snapshot.
+ * @note Caches the path of every outer it sees, so each object's name is just a single append
+ *       onto it's outer's. Not thread safe, each thread should use their own builder.
+ */
+class PathNameBuilder {
+   public:
+    /**
+     * @brief Creates a new builder.
+     *
+     * @param records All records, sorted by object.
+     * @param package_class The address of the package class.
+     */
+    PathNameBuilder(std::span<const ObjectRecord> records, uintptr_t package_class);
+
+    /**
+     * @brief Adds an object to a shard, alongside it's path name.
+     * @note Matches the format of `UObject::get_path_name`.
+     *
+     * @param idx The index of the object's record.
+     * @param shard The shard to add the object to.
+     */
+    void add_object(size_t idx, GraphShard& shard);
+
+   private:
+    static constexpr size_t INVALID_IDX = std::numeric_limits<size_t>::max();
+    // Marks an outer path as still being built, used to detect looping outer chains
+    static constexpr std::pair<size_t, size_t> IN_PROGRESS{INVALID_IDX, 0};
+    // Marks an outer whose chain loops or is too deep, which has no usable path
+    static constexpr std::pair<size_t, size_t> BROKEN{INVALID_IDX, 1};
+    // Real outer chains are only a handful deep, this just stops corrupt ones overflowing the stack
+    static constexpr size_t MAX_OUTER_DEPTH = 256;
+
+    std::span<const ObjectRecord> records;
+    uintptr_t package_class;
+
+    // All the outer paths we've built so far, concatenated together, and the range of each one
+    std::string outer_paths;
+    std::unordered_map<size_t, std::pair<size_t, size_t>> outer_path_ranges;
+
+    // Every base name we've converted so far, concatenated together, and the range of each one,
+    // keyed by their index in the global name table
+    std::string base_names;
+    std::unordered_map<int32_t, std::pair<size_t, size_t>> base_name_ranges;
+
+    /**
+     * @brief Looks up the index of the given object's record.
+     *
+     * @param obj The object to look up.
+     * @return The index of it's record, or INVALID_IDX if it doesn't exist.
+     */
+    [[nodiscard]] size_t find_record(uintptr_t obj) const;
+
+    /**
+     * @brief Gets the separator to put between an outer's path name and it's child's name.
+     *
+     * @param outer_idx The index of the outer's record.
+     * @return The separator.
+     */
+    [[nodiscard]] char separator(size_t outer_idx) const;
+
+    /**
+     * @brief Appends a name to a string.
+     * @note Most names are one of a few common base names plus a unique number, so we only convert
+     *       each base name once, and format the number ourselves.
+     *
+     * @param name The name to append.
+     * @param str The string to append to.
+     */
+    void append_name(const unrealsdk::unreal::FName& name, std::string& str);
+
+    /**
+     * @brief Gets the full path name of an object being used as an outer, building it if needed.
+     *
+     * @param idx The index of the object's record.
+     * @param depth How many outers deep we already are.
+     * @return The path name, or an empty optional if it's outer chain loops or is too deep. Only
+     *         valid until the next call.
+     */
+    std::optional<std::string_view> outer_path(size_t idx, size_t depth);
+
+    struct PathPrefix {
+        std::string_view outer_path;
+        char separator;
+    };
+
+    /**
+     * @brief Gets everything which goes before an object's own name in it's path name.
+     * @note If the outer chain loops or is too deep, falls back to an empty prefix, so the object
+     *       just gets it's bare name.
+     *
+     * @param idx The index of the object's record.
+     * @return The prefix. Only valid until the next call to `outer_path`.
+     */
+    PathPrefix path_prefix(size_t idx);
+
+    /**
+     * @brief Appends an object's path name to a string.
+     *
+     * @param prefix The object's prefix.
+     * @param idx The index of the object's record.
+     * @param str The string to append to.
+     */
+    void append_path(const PathPrefix& prefix, size_t idx, std::string& str);
+};
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_PATH_NAMES_H */
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "refs/paths.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+/**
+ * @brief Counts how many refs expanding a frontier would have to look at.
+ *
+ * @param frontier The frontier.
+ * @param get_refs Gets the refs to follow from an object.
+ * @return The total number of refs.
+ */
+template <typename Fn>
+size_t frontier_cost(const std::vector<object_id>& frontier, Fn get_refs) {
+    size_t cost = 0;
+    for (auto id : frontier) {
+        cost += get_refs(id).size();
+    }
+    return cost;
+}
+
+/**
+ * @brief Expands a frontier by one level.
+ *
+ * @param frontier The frontier to expand. Replaced with the next level.
+ * @param next Scratch space for the next level.
+ * @param get_refs Gets the refs to follow from an object.
+ * @param visited The object we first reached each object from on this side, or INVALID_ID.
+ * @param other_visited The same array for the other side.
+ * @return All objects newly reached on this side which the other side had already reached.
+ */
+template <typename Fn>
+std::vector<object_id> expand_frontier(std::vector<object_id>& frontier,
+                                       std::vector<object_id>& next,
+                                       Fn get_refs,
+                                       std::vector<object_id>& visited,
+                                       const std::vector<object_id>& other_visited) {
+    std::vector<object_id> meets{};
+    next.clear();
+    for (auto id : frontier) {
+        for (auto ref : get_refs(id)) {
+            if (visited[ref] != Graph::INVALID_ID) {
+                continue;
+            }
+            visited[ref] = id;
+            if (other_visited[ref] != Graph::INVALID_ID) {
+                meets.push_back(ref);
+            }
+            next.push_back(ref);
+        }
+    }
+    std::swap(frontier, next);
+    return meets;
+}
+
+/**
+ * @brief Gets how many steps a chain takes to reach the object which started it.
+ *
+ * @param visited The object we first reached each object from. Starting objects map to themselves.
+ * @param id The object to start at.
+ * @return The length of the chain.
+ */
+size_t chain_length(const std::vector<object_id>& visited, object_id id) {
+    size_t length = 0;
+    for (; visited[id] != id; id = visited[id]) {
+        length++;
+    }
+    return length;
+}
+
+}  // namespace
+
+std::vector<object_id> find_shortest_path(const Graph& graph,
+                                          std::span<const object_id> roots,
+                                          object_id target) {
+    auto refs_from = [&graph](object_id id) { return graph.refs_from(id); };
+    auto refs_to = [&graph](object_id id) { return graph.refs_to(id); };
+
+    // The object we first reached each object from, searching forwards from the roots, or
+    // backwards from the target. Starting objects map to themselves.
+    std::vector<object_id> forward_parent(graph.num_objects(), Graph::INVALID_ID);
+    std::vector<object_id> backward_child(graph.num_objects(), Graph::INVALID_ID);
+
+    std::vector<object_id> forward_frontier{};
+    for (auto root : roots) {
+        if (forward_parent[root] == Graph::INVALID_ID) {
+            forward_parent[root] = root;
+            forward_frontier.push_back(root);
+        }
+    }
+    if (forward_parent[target] != Graph::INVALID_ID) {
+        return {target};
+    }
+    backward_child[target] = target;
+    std::vector<object_id> backward_frontier{target};
+
+    std::vector<object_id> next{};
+    std::vector<object_id> meets{};
+    while (meets.empty() && !forward_frontier.empty() && !backward_frontier.empty()) {
+        if (frontier_cost(forward_frontier, refs_from)
+            <= frontier_cost(backward_frontier, refs_to)) {
+            meets = expand_frontier(forward_frontier, next, refs_from, forward_parent,
+                                    backward_child);
+        } else {
+            meets = expand_frontier(backward_frontier, next, refs_to, backward_child,
+                                    forward_parent);
+        }
+    }
+    if (meets.empty()) {
+        return {};
+    }
+
+    // Everything we just reached is the same distance from our side, but the other side may have
+    // reached them at different depths, so pick whichever's closest
+    auto meet = std::ranges::min(meets, {}, [&](object_id id) {
+        return chain_length(forward_parent, id) + chain_length(backward_child, id);
+    });
+
+    std::vector<object_id> path{};
+    for (auto id = meet; forward_parent[id] != id; id = forward_parent[id]) {
+        path.push_back(forward_parent[id]);
+    }
+    std::ranges::reverse(path);
+    for (auto id = meet; id != target; id = backward_child[id]) {
+        path.push_back(id);
+    }
+    path.push_back(target);
+    return path;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,26 @@
+#ifndef REFS_PATHS_H
+#define REFS_PATHS_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Finds the shortest chain of references leading from any of the given roots to an object.
+ * @note Searches forwards from the roots and backwards from the target at the same time, always
+ *       expanding whichever side has fewer refs to look at, so a large root set doesn't mean having
+ *       to walk most of the graph.
+ *
+ * @param graph The graph to search.
+ * @param roots The objects to start from.
+ * @param target The object to find a path to.
+ * @return The path, starting at a root and ending at the target. Empty if there's no path.
+ */
+[[nodiscard]] std::vector<object_id> find_shortest_path(const Graph& graph,
+                                                        std::span<const object_id> roots,
+                                                        object_id target);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_PATHS_H */
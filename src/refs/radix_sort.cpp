@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "refs/radix_sort.h"
+#include "refs/parallel_for.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+const constexpr size_t DIGIT_BITS = 8;
+const constexpr size_t NUM_BUCKETS = 1 << DIGIT_BITS;
+
+// Below this it's not worth handing work to other threads, and the std sort wins anyway
+const constexpr size_t MIN_RADIX_SIZE = 0x10000;
+
+using histogram = std::array<size_t, NUM_BUCKETS>;
+
+/**
+ * @brief Gets a single digit of a key.
+ *
+ * @tparam T The type of the key.
+ * @param key The key.
+ * @param digit The index of the digit, starting from the least significant.
+ * @return The digit.
+ */
+template <typename T>
+constexpr size_t get_digit(T key, size_t digit) {
+    return (key >> (digit * DIGIT_BITS)) & (NUM_BUCKETS - 1);
+}
+
+/**
+ * @brief Runs a function on multiple threads, each processing a contiguous block of keys.
+ *
+ * @param size The total number of keys.
+ * @param thread_count How many threads to run.
+ * @param func The function to run. Gets passed the thread's index, and the range of keys it should
+ *             process.
+ */
+void for_each_block(
+    size_t size,
+    size_t thread_count,
+    const std::function<void(size_t thread_idx, size_t start_idx, size_t end_idx)>& func) {
+    auto per_thread = (size + thread_count - 1) / thread_count;
+
+    run_on_workers(thread_count, [size, per_thread, &func](size_t thread_idx) {
+        auto start_idx = std::min(thread_idx * per_thread, size);
+        auto end_idx = std::min(start_idx + per_thread, size);
+        func(thread_idx, start_idx, end_idx);
+    });
+}
+
+}  // namespace
+
+template <typename T>
+    requires std::is_unsigned_v<T>
+void radix_sort(std::vector<T>& keys, size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    if (keys.size() < MIN_RADIX_SIZE) {
+        std::ranges::sort(keys);
+        return;
+    }
+
+    // Work out which digits actually need sorting, by checking if any key differs from the first
+    // Since the blocks cover every key, each thread can just or together what it sees
+    std::vector<T> thread_differing_bits(thread_count);
+    for_each_block(keys.size(), thread_count,
+                   [&keys, &thread_differing_bits](size_t thread_idx, size_t start_idx,
+                                                   size_t end_idx) {
+                       T differing = 0;
+                       for (auto i = start_idx; i < end_idx; i++) {
+                           differing |= keys[i] ^ keys.front();
+                       }
+                       thread_differing_bits[thread_idx] = differing;
+                   });
+    auto differing_bits = std::reduce(thread_differing_bits.begin(), thread_differing_bits.end(),
+                                      T{0}, std::bit_or{});
+
+    std::vector<T> scratch(keys.size());
+    std::vector<histogram> thread_counts(thread_count);
+
+    const constexpr size_t num_digits = sizeof(T) * CHAR_BIT / DIGIT_BITS;
+    for (size_t digit = 0; digit < num_digits; digit++) {
+        if (get_digit(differing_bits, digit) == 0) {
+            continue;
+        }
+
+        // Count how many keys each thread has in each bucket
+        for_each_block(keys.size(), thread_count,
+                       [&keys, &thread_counts, digit](size_t thread_idx, size_t start_idx,
+                                                      size_t end_idx) {
+                           auto& counts = thread_counts[thread_idx];
+                           counts.fill(0);
+                           for (auto i = start_idx; i < end_idx; i++) {
+                               counts[get_digit(keys[i], digit)]++;
+                           }
+                       });
+
+        // Turn the counts into where each thread should start writing each bucket. Ordering by
+        // bucket then thread keeps the sort stable, which LSD relies on.
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+            for (auto& counts : thread_counts) {
+                auto count = counts[bucket];
+                counts[bucket] = offset;
+                offset += count;
+            }
+        }
+
+        for_each_block(keys.size(), thread_count,
+                       [&keys, &scratch, &thread_counts, digit](size_t thread_idx, size_t start_idx,
+                                                                size_t end_idx) {
+                           auto& offsets = thread_counts[thread_idx];
+                           for (auto i = start_idx; i < end_idx; i++) {
+                               scratch[offsets[get_digit(keys[i], digit)]++] = keys[i];
+                           }
+                       });
+
+        keys.swap(scratch);
+    }
+}
+
+template <typename T>
+    requires std::is_unsigned_v<T>
+void sort_unique(std::vector<T>& keys, size_t thread_count) {
+    radix_sort(keys, thread_count);
+    auto [first_dup, last] = std::ranges::unique(keys);
+    keys.erase(first_dup, last);
+}
+
+template void radix_sort<uint32_t>(std::vector<uint32_t>& keys, size_t thread_count);
+template void radix_sort<uint64_t>(std::vector<uint64_t>& keys, size_t thread_count);
+template void sort_unique<uint32_t>(std::vector<uint32_t>& keys, size_t thread_count);
+template void sort_unique<uint64_t>(std::vector<uint64_t>& keys, size_t thread_count);
+
+}  // namespace live_object_explorer::refs::internal
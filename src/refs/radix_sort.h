@@ -0,0 +1,34 @@
+#ifndef REFS_RADIX_SORT_H
+#define REFS_RADIX_SORT_H
+
+#include "pch.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Sorts a list of keys, using a parallel LSD radix sort.
+ * @note Skips any byte which is the same in every key, so sorting e.g. pointers with unused high
+ *       bits only costs as many passes as there are bytes which actually differ.
+ *
+ * @tparam T The type of the keys. Only instantiated for 32 and 64-bit unsigned ints.
+ * @param keys The keys to sort. Sorted in place.
+ * @param thread_count How many threads to split each pass between.
+ */
+template <typename T>
+    requires std::is_unsigned_v<T>
+void radix_sort(std::vector<T>& keys, size_t thread_count);
+
+/**
+ * @brief Sorts a list of keys, and removes any duplicates.
+ *
+ * @tparam T The type of the keys. Only instantiated for 32 and 64-bit unsigned ints.
+ * @param keys The keys to sort. Sorted and deduplicated in place.
+ * @param thread_count How many threads to use while sorting.
+ */
+template <typename T>
+    requires std::is_unsigned_v<T>
+void sort_unique(std::vector<T>& keys, size_t thread_count);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_RADIX_SORT_H */
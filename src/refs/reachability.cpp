@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "refs/reachability.h"
+#include "refs/graph.h"
+#include "refs/parallel_for.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+using visited_set = std::vector<std::atomic<uint64_t>>;
+
+constexpr size_t BITS_PER_WORD = std::numeric_limits<uint64_t>::digits;
+
+// Levels smaller than this finish faster on a single thread than it takes to hand them out
+constexpr size_t MIN_PARALLEL_LEVEL = 0x4000;
+
+/**
+ * @brief Marks an object as visited.
+ * @note Thread safe.
+ *
+ * @param visited The visited set.
+ * @param id The object to mark.
+ * @return True if this call marked the object, false if it was already visited.
+ */
+bool try_visit(visited_set& visited, object_id id) {
+    auto& word = visited[id / BITS_PER_WORD];
+    const uint64_t bit = uint64_t{1} << (id % BITS_PER_WORD);
+
+    // Most refs lead to already visited objects, a plain load is much cheaper than always writing
+    if ((word.load(std::memory_order_relaxed) & bit) != 0) {
+        return false;
+    }
+    return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+}
+
+/**
+ * @brief Visits everything referenced by the given objects.
+ * @note Thread safe, so long as each thread uses it's own next level.
+ *
+ * @param graph The graph being searched.
+ * @param visited The visited set.
+ * @param level The objects to expand.
+ * @param next_level A vector to append newly visited objects to.
+ */
+void expand_level(const Graph& graph,
+                  visited_set& visited,
+                  std::span<const object_id> level,
+                  std::vector<object_id>& next_level) {
+    for (auto id : level) {
+        for (auto ref : graph.refs_from(id)) {
+            if (try_visit(visited, ref)) {
+                next_level.push_back(ref);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+std::vector<object_id> find_unreachable(const Graph& graph,
+                                        std::span<const object_id> roots,
+                                        size_t thread_count,
+                                        const std::stop_token& stop_token) {
+    auto num_objects = graph.num_objects();
+    visited_set visited((num_objects + BITS_PER_WORD - 1) / BITS_PER_WORD);
+
+    std::vector<object_id> level{};
+    for (auto root : roots) {
+        if (try_visit(visited, root)) {
+            level.push_back(root);
+        }
+    }
+
+    std::vector<std::vector<object_id>> thread_levels(thread_count);
+    while (!level.empty()) {
+        if (stop_token.stop_requested()) {
+            return {};
+        }
+        std::vector<object_id> next_level{};
+
+        if (thread_count <= 1 || level.size() < MIN_PARALLEL_LEVEL) {
+            expand_level(graph, visited, level, next_level);
+        } else {
+            parallel_for(level.size(), thread_count,
+                         [&graph, &visited, &level, &thread_levels, &stop_token](
+                             size_t thread_idx, ChunkCursor& cursor) {
+                             size_t start_idx = 0;
+                             size_t end_idx = 0;
+                             while (!stop_token.stop_requested()
+                                    && cursor.next(start_idx, end_idx)) {
+                                 expand_level(graph, visited,
+                                              std::span{level}.subspan(start_idx,
+                                                                       end_idx - start_idx),
+                                              thread_levels[thread_idx]);
+                             }
+                         });
+
+            for (auto& thread_level : thread_levels) {
+                next_level.insert(next_level.end(), thread_level.begin(), thread_level.end());
+                thread_level.clear();
+            }
+        }
+
+        level = std::move(next_level);
+    }
+
+    std::vector<object_id> unreachable{};
+    for (size_t word_idx = 0; word_idx < visited.size(); word_idx++) {
+        auto missing = ~visited[word_idx].load(std::memory_order_relaxed);
+        while (missing != 0) {
+            auto id = (word_idx * BITS_PER_WORD) + std::countr_zero(missing);
+            if (id >= num_objects) {
+                break;
+            }
+            unreachable.push_back(static_cast<object_id>(id));
+            missing &= missing - 1;
+        }
+    }
+    return unreachable;
+}
+
+}  // namespace live_object_explorer::refs::internal
@@ -0,0 +1,27 @@
+#ifndef REFS_REACHABILITY_H
+#define REFS_REACHABILITY_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Finds every object which can't be reached from any of the given roots.
+ * @note Runs a level by level breadth first search, with each large enough level split between
+ *       multiple threads. Visited objects are tracked in a shared bitset.
+ *
+ * @param graph The graph to search.
+ * @param roots The objects to start searching from.
+ * @param thread_count The most threads to use.
+ * @param stop_token A stop token, to cancel the search early.
+ * @return The unreachable objects' ids, sorted. Empty if cancelled.
+ */
+[[nodiscard]] std::vector<object_id> find_unreachable(const Graph& graph,
+                                                      std::span<const object_id> roots,
+                                                      size_t thread_count,
+                                                      const std::stop_token& stop_token);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_REACHABILITY_H */
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "refs/roots.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+constexpr uint8_t ALWAYS_ALIVE_FLAGS =
+    OBJECT_FLAG_ROOT | OBJECT_FLAG_DEFAULT | OBJECT_FLAG_SINGLETON;
+
+}  // namespace
+
+std::vector<object_id> find_roots(const Graph& graph, RootKind kind) {
+    std::vector<object_id> roots{};
+    for (object_id id = 0; id < graph.num_objects(); id++) {
+        switch (kind) {
+            case RootKind::FLAGGED:
+                if ((graph.flags(id) & OBJECT_FLAG_ROOT) != 0) {
+                    roots.push_back(id);
+                }
+                break;
+            case RootKind::SINGLETONS:
+                if ((graph.flags(id) & OBJECT_FLAG_SINGLETON) != 0) {
+                    roots.push_back(id);
+                }
+                break;
+            case RootKind::ALWAYS_ALIVE:
+                if ((graph.flags(id) & ALWAYS_ALIVE_FLAGS) != 0) {
+                    roots.push_back(id);
+                }
+                break;
+        }
+    }
+    return roots;
+}
+
+}  // namespace live_object_explorer::refs::internal
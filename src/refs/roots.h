@@ -0,0 +1,33 @@
+#ifndef REFS_ROOTS_H
+#define REFS_ROOTS_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Which objects to treat as roots, when working out what keeps other objects alive.
+ */
+enum class RootKind : uint8_t {
+    // Objects the engine flagged as always being kept alive
+    FLAGGED,
+    // The engine and world singletons, which everything in the running game hangs off of
+    SINGLETONS,
+    // Everything the garbage collector keeps alive regardless of refs: flagged objects, class
+    // default objects, and the engine and world singletons
+    ALWAYS_ALIVE,
+};
+
+/**
+ * @brief Finds all roots of the given kind.
+ *
+ * @param graph The graph to search.
+ * @param kind Which objects to treat as roots.
+ * @return The roots' ids, sorted.
+ */
+[[nodiscard]] std::vector<object_id> find_roots(const Graph& graph, RootKind kind);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_ROOTS_H */
@@ -0,0 +1,536 @@
+#include "pch.h"
+#include "refs/snapshot_file.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+namespace {
+
+const constexpr std::array<char, 8> FILE_MAGIC = {'L', 'O', 'E', 'R', 'E', 'F', 'S', '\0'};
+const constexpr uint32_t FILE_VERSION = 4;
+
+// NOLINTNEXTLINE(performance-enum-size)
+enum SectionId : size_t {
+    // The address of each object, delta encoded against the previous one
+    SECTION_POINTERS,
+    // The GObjects index of each object plus one, or zero if unknown
+    SECTION_GOBJECTS_INDEXES,
+    // The class id, and the outer id, of each object plus one, or zero if unknown
+    SECTION_CLASS_IDS,
+    SECTION_OUTER_IDS,
+    // The flags of each object, one raw byte each
+    SECTION_FLAGS,
+    // The shallow size of each object
+    SECTION_SHALLOW_SIZES,
+    // Each name as the size of it's prefix shared with the previous name, the size of the rest,
+    // then the rest of the name
+    SECTION_NAMES,
+    // Each object's ref count, followed by the ids it references, delta encoded against the
+    // previous one
+    SECTION_REFS,
+
+    NUM_SECTIONS,
+};
+
+struct Section {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Only the forward refs get stored, rebuilding the reverse ones is a single pass over them, which
+// is just as quick as decoding a second copy would be
+struct FileHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    // Addresses are stored full width, don't try load a file from a game with different sizes
+    uint32_t pointer_size;
+    uint64_t num_objects;
+    uint64_t num_refs;
+    std::array<Section, NUM_SECTIONS> sections;
+};
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+
+/**
+ * @brief Appends a varint to a buffer.
+ *
+ * @param buffer The buffer to append to.
+ * @param value The value to append.
+ */
+void write_varint(std::string& buffer, uint64_t value) {
+    const constexpr auto continue_bit = 0x80;
+    const constexpr auto value_mask = 0x7F;
+    const constexpr auto bits_per_byte = 7;
+
+    while (value >= continue_bit) {
+        buffer.push_back(static_cast<char>((value & value_mask) | continue_bit));
+        value >>= bits_per_byte;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Reads values back out of a single section.
+ * @note Never reads past the end of the section, instead latching an error flag, so that callers
+ *       only need to check it once at the end.
+ */
+class SectionReader {
+   public:
+    /**
+     * @brief Creates a new reader.
+     *
+     * @param data The section's data.
+     */
+    explicit SectionReader(std::span<const uint8_t> data) : data(data) {}
+
+    /**
+     * @brief Reads a single varint.
+     *
+     * @return The read value, or 0 on error.
+     */
+    uint64_t read_varint(void) {
+        const constexpr auto continue_bit = 0x80;
+        const constexpr auto value_mask = 0x7F;
+        const constexpr auto bits_per_byte = 7;
+        const constexpr auto max_shift = 63;
+
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift <= max_shift; shift += bits_per_byte) {
+            if (this->pos >= this->data.size()) {
+                break;
+            }
+            auto byte = this->data[this->pos++];
+            value |= static_cast<uint64_t>(byte & value_mask) << shift;
+            if ((byte & continue_bit) == 0) {
+                return value;
+            }
+        }
+
+        this->failed = true;
+        return 0;
+    }
+
+    /**
+     * @brief Reads a run of raw bytes.
+     *
+     * @param size How many bytes to read.
+     * @return The read bytes, or an empty string on error.
+     */
+    std::string_view read_bytes(size_t size) {
+        if (size > this->data.size() - this->pos) {
+            this->failed = true;
+            return {};
+        }
+        auto bytes = this->data.subspan(this->pos, size);
+        this->pos += size;
+        return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+    }
+
+    /**
+     * @brief Checks if all reads so far succeeded, and used up the entire section.
+     *
+     * @return True if the whole section was valid.
+     */
+    [[nodiscard]] bool finished(void) const {
+        return !this->failed && this->pos == this->data.size();
+    }
+
+   private:
+    std::span<const uint8_t> data;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+/**
+ * @brief A read only view of an entire file, mapped into memory.
+ */
+class MappedFile {
+   public:
+    /**
+     * @brief Maps a file.
+     *
+     * @param path The path of the file to map.
+     */
+    explicit MappedFile(const std::filesystem::path& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    ~MappedFile();
+
+    /**
+     * @brief Gets the contents of the file.
+     *
+     * @return The file contents. Empty if it failed to map.
+     */
+    [[nodiscard]] std::span<const uint8_t> data(void) const {
+        return {static_cast<const uint8_t*>(this->view), this->size};
+    }
+
+   private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+    const void* view = nullptr;
+    size_t size = 0;
+};
+
+// The game only runs on Windows, the posix version is just so the refs engine can be benchmarked
+// standalone
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    this->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        LOG(ERROR, "Failed to open snapshot file: {}", GetLastError());
+        return;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (GetFileSizeEx(this->file, &file_size) == 0) {
+        LOG(ERROR, "Failed to get snapshot file size: {}", GetLastError());
+        return;
+    }
+    if (file_size.QuadPart == 0) {
+        // Can't map an empty file, leave it as an empty view
+        return;
+    }
+
+    this->mapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->mapping == nullptr) {
+        LOG(ERROR, "Failed to map snapshot file: {}", GetLastError());
+        return;
+    }
+
+    this->view = MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (this->view == nullptr) {
+        LOG(ERROR, "Failed to map view of snapshot file: {}", GetLastError());
+        return;
+    }
+    this->size = static_cast<size_t>(file_size.QuadPart);
+}
+
+MappedFile::~MappedFile() {
+    if (this->view != nullptr) {
+        UnmapViewOfFile(this->view);
+    }
+    if (this->mapping != nullptr) {
+        CloseHandle(this->mapping);
+    }
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    this->file = open(path.c_str(), O_RDONLY);
+    if (this->file < 0) {
+        LOG(ERROR, "Failed to open snapshot file: {}", errno);
+        return;
+    }
+
+    struct stat file_stat{};
+    if (fstat(this->file, &file_stat) != 0) {
+        LOG(ERROR, "Failed to get snapshot file size: {}", errno);
+        return;
+    }
+    if (file_stat.st_size == 0) {
+        // Can't map an empty file, leave it as an empty view
+        return;
+    }
+
+    auto view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE,
+                     this->file, 0);
+    if (view == MAP_FAILED) {
+        LOG(ERROR, "Failed to map snapshot file: {}", errno);
+        return;
+    }
+    this->view = view;
+    this->size = static_cast<size_t>(file_stat.st_size);
+}
+
+MappedFile::~MappedFile() {
+    if (this->view != nullptr) {
+        munmap(const_cast<void*>(this->view), this->size);
+    }
+    if (this->file >= 0) {
+        close(this->file);
+    }
+}
+
+#endif
+
+}  // namespace
+
+std::string encode_snapshot(const Graph& graph) {
+    std::array<std::string, NUM_SECTIONS> sections{};
+
+    uintptr_t prev_ptr = 0;
+    std::string_view prev_name{};
+    for (object_id id = 0; id < graph.num_objects(); id++) {
+        auto ptr = graph.pointer(id);
+        write_varint(sections[SECTION_POINTERS], ptr - prev_ptr);
+        prev_ptr = ptr;
+
+        auto gobjects_idx = graph.gobjects_index(id);
+        write_varint(sections[SECTION_GOBJECTS_INDEXES],
+                     gobjects_idx == UNKNOWN_GOBJECTS_IDX ? 0 : uint64_t{gobjects_idx} + 1);
+
+        auto class_id = graph.class_id(id);
+        write_varint(sections[SECTION_CLASS_IDS],
+                     class_id == Graph::INVALID_ID ? 0 : uint64_t{class_id} + 1);
+        auto outer_id = graph.outer_id(id);
+        write_varint(sections[SECTION_OUTER_IDS],
+                     outer_id == Graph::INVALID_ID ? 0 : uint64_t{outer_id} + 1);
+
+        sections[SECTION_FLAGS].push_back(static_cast<char>(graph.flags(id)));
+        write_varint(sections[SECTION_SHALLOW_SIZES], graph.shallow_size(id));
+
+        // Objects sharing an outer tend to be allocated together, so even in address order
+        // neighbouring names usually share a long prefix
+        auto name = graph.name(id);
+        auto [name_mismatch, _] = std::ranges::mismatch(name, prev_name);
+        auto shared_size = static_cast<size_t>(name_mismatch - name.begin());
+        write_varint(sections[SECTION_NAMES], shared_size);
+        write_varint(sections[SECTION_NAMES], name.size() - shared_size);
+        sections[SECTION_NAMES].append(name.substr(shared_size));
+        prev_name = name;
+
+        auto refs = graph.refs_from(id);
+        write_varint(sections[SECTION_REFS], refs.size());
+        object_id prev_to = 0;
+        for (auto to : refs) {
+            write_varint(sections[SECTION_REFS], to - prev_to);
+            prev_to = to;
+        }
+    }
+
+    FileHeader header{
+        .magic = FILE_MAGIC,
+        .version = FILE_VERSION,
+        .pointer_size = sizeof(uintptr_t),
+        .num_objects = graph.num_objects(),
+        .num_refs = graph.num_refs(),
+        .sections = {},
+    };
+    uint64_t offset = sizeof(header);
+    for (size_t i = 0; i < NUM_SECTIONS; i++) {
+        header.sections[i] = {.offset = offset, .size = sections[i].size()};
+        offset += sections[i].size();
+    }
+
+    std::string file{};
+    file.reserve(offset);
+    file.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (auto& section : sections) {
+        file.append(section);
+        section = {};
+    }
+    return file;
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+std::shared_ptr<const Graph> decode_snapshot(std::span<const uint8_t> data) {
+    FileHeader header{};
+    if (data.size() < sizeof(header)) {
+        LOG(ERROR, "Snapshot file is too small");
+        return nullptr;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != FILE_MAGIC) {
+        LOG(ERROR, "Not a snapshot file");
+        return nullptr;
+    }
+    if (header.version != FILE_VERSION) {
+        LOG(ERROR, "Can't load snapshot file version {}, expected {}", header.version,
+            FILE_VERSION);
+        return nullptr;
+    }
+    if (header.pointer_size != sizeof(uintptr_t)) {
+        LOG(ERROR, "Can't load snapshot file from a game with {} byte pointers",
+            header.pointer_size);
+        return nullptr;
+    }
+    // Every object and ref takes at least a byte, so this also rules out absurd allocations
+    if (header.num_objects >= Graph::INVALID_ID || header.num_objects > data.size()
+        || header.num_refs > data.size()) {
+        LOG(ERROR, "Snapshot file is corrupt: invalid counts");
+        return nullptr;
+    }
+    for (const auto& section : header.sections) {
+        if (section.offset > data.size() || section.size > data.size() - section.offset) {
+            LOG(ERROR, "Snapshot file is corrupt: section out of bounds");
+            return nullptr;
+        }
+    }
+
+    auto section_reader = [&](SectionId section_id) {
+        const auto& section = header.sections[section_id];
+        return SectionReader{data.subspan(static_cast<size_t>(section.offset),
+                                          static_cast<size_t>(section.size))};
+    };
+    auto num_objects = static_cast<size_t>(header.num_objects);
+    auto num_refs = static_cast<size_t>(header.num_refs);
+    bool valid = true;
+
+    std::vector<uintptr_t> pointers(num_objects);
+    auto pointers_reader = section_reader(SECTION_POINTERS);
+    uint64_t ptr = 0;
+    for (size_t i = 0; i < num_objects; i++) {
+        auto delta = pointers_reader.read_varint();
+        // Addresses must be strictly increasing
+        if ((i != 0 && delta == 0) || delta > std::numeric_limits<uintptr_t>::max() - ptr) {
+            valid = false;
+            break;
+        }
+        ptr += delta;
+        pointers[i] = static_cast<uintptr_t>(ptr);
+    }
+    valid = valid && pointers_reader.finished();
+
+    std::vector<uint32_t> gobjects_indexes(num_objects);
+    auto gobjects_reader = section_reader(SECTION_GOBJECTS_INDEXES);
+    for (size_t i = 0; i < num_objects && valid; i++) {
+        auto idx = gobjects_reader.read_varint();
+        if (idx > UNKNOWN_GOBJECTS_IDX) {
+            valid = false;
+            break;
+        }
+        gobjects_indexes[i] = idx == 0 ? UNKNOWN_GOBJECTS_IDX : static_cast<uint32_t>(idx - 1);
+    }
+    valid = valid && gobjects_reader.finished();
+
+    auto read_ids = [&](SectionId section_id, std::vector<object_id>& ids) {
+        ids.resize(num_objects);
+        auto reader = section_reader(section_id);
+        for (size_t i = 0; i < num_objects && valid; i++) {
+            auto id = reader.read_varint();
+            if (id > num_objects) {
+                valid = false;
+                break;
+            }
+            ids[i] = id == 0 ? Graph::INVALID_ID : static_cast<object_id>(id - 1);
+        }
+        valid = valid && reader.finished();
+    };
+    std::vector<object_id> class_ids{};
+    read_ids(SECTION_CLASS_IDS, class_ids);
+    std::vector<object_id> outer_ids{};
+    read_ids(SECTION_OUTER_IDS, outer_ids);
+
+    std::vector<uint8_t> flags(num_objects);
+    auto flags_reader = section_reader(SECTION_FLAGS);
+    if (valid) {
+        auto flag_bytes = flags_reader.read_bytes(num_objects);
+        std::ranges::copy(flag_bytes, flags.begin());
+    }
+    valid = valid && flags_reader.finished();
+
+    std::vector<uint32_t> shallow_sizes(num_objects);
+    auto sizes_reader = section_reader(SECTION_SHALLOW_SIZES);
+    for (size_t i = 0; i < num_objects && valid; i++) {
+        auto size = sizes_reader.read_varint();
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            valid = false;
+            break;
+        }
+        shallow_sizes[i] = static_cast<uint32_t>(size);
+    }
+    valid = valid && sizes_reader.finished();
+
+    std::string name_data{};
+    std::vector<size_t> name_offsets{};
+    name_offsets.reserve(num_objects + 1);
+    auto names_reader = section_reader(SECTION_NAMES);
+    size_t prev_name_start = 0;
+    for (size_t i = 0; i < num_objects && valid; i++) {
+        auto shared_size = names_reader.read_varint();
+        auto suffix_size = names_reader.read_varint();
+        auto start = name_data.size();
+        if (shared_size > start - prev_name_start) {
+            valid = false;
+            break;
+        }
+
+        name_offsets.push_back(start);
+        // Can't append from our own buffer, since it may reallocate
+        name_data.resize(start + static_cast<size_t>(shared_size));
+        std::copy_n(name_data.begin() + static_cast<ptrdiff_t>(prev_name_start),
+                    static_cast<size_t>(shared_size),
+                    name_data.begin() + static_cast<ptrdiff_t>(start));
+        name_data.append(names_reader.read_bytes(static_cast<size_t>(suffix_size)));
+        prev_name_start = start;
+    }
+    name_offsets.push_back(name_data.size());
+    valid = valid && names_reader.finished();
+
+    std::vector<size_t> from_offsets{};
+    std::vector<object_id> from_refs{};
+    from_offsets.reserve(num_objects + 1);
+    from_refs.reserve(num_refs);
+    auto refs_reader = section_reader(SECTION_REFS);
+    for (size_t i = 0; i < num_objects && valid; i++) {
+        from_offsets.push_back(from_refs.size());
+
+        auto count = refs_reader.read_varint();
+        if (count > num_refs - from_refs.size()) {
+            valid = false;
+            break;
+        }
+        uint64_t to = 0;
+        for (uint64_t j = 0; j < count; j++) {
+            auto delta = refs_reader.read_varint();
+            // Each object's refs must be strictly increasing
+            if ((j != 0 && delta == 0) || delta >= num_objects - to) {
+                valid = false;
+                break;
+            }
+            to += delta;
+            from_refs.push_back(static_cast<object_id>(to));
+        }
+    }
+    from_offsets.push_back(from_refs.size());
+    valid = valid && refs_reader.finished() && from_refs.size() == num_refs;
+
+    if (!valid) {
+        LOG(ERROR, "Snapshot file is corrupt: invalid section contents");
+        return nullptr;
+    }
+
+    return std::make_shared<const Graph>(
+        std::move(pointers), std::move(gobjects_indexes), std::move(class_ids),
+        std::move(outer_ids), std::move(flags), std::move(shallow_sizes), std::move(name_data),
+        std::move(name_offsets), std::move(from_offsets), std::move(from_refs));
+}
+
+bool write_snapshot_file(const std::filesystem::path& path, const Graph& graph) {
+    auto contents = encode_snapshot(graph);
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    file.close();
+    if (file.fail()) {
+        LOG(ERROR, "Failed to write snapshot file");
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const Graph> read_snapshot_file(const std::filesystem::path& path) {
+    const MappedFile file{path};
+    if (file.data().empty()) {
+        LOG(ERROR, "Failed to read snapshot file");
+        return nullptr;
+    }
+    return decode_snapshot(file.data());
+}
+
+}  // namespace live_object_explorer::refs::internal
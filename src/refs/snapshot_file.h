@@ -0,0 +1,47 @@
+#ifndef REFS_SNAPSHOT_FILE_H
+#define REFS_SNAPSHOT_FILE_H
+
+#include "pch.h"
+#include "refs/graph.h"
+
+namespace live_object_explorer::refs::internal {
+
+/**
+ * @brief Encodes a graph into our native snapshot file format.
+ * @note The file is a fixed header followed by a handful of sections. Addresses and adjacency
+ *       lists are delta + varint encoded, and names are front coded against the previous one.
+ *
+ * @param graph The graph to encode.
+ * @return The encoded file contents.
+ */
+std::string encode_snapshot(const Graph& graph);
+
+/**
+ * @brief Decodes a graph from our native snapshot file format.
+ *
+ * @param data The file contents.
+ * @return The decoded graph, or null if the file was invalid.
+ */
+std::shared_ptr<const Graph> decode_snapshot(std::span<const uint8_t> data);
+
+/**
+ * @brief Writes a graph to a native snapshot file.
+ *
+ * @param path The path to write to.
+ * @param graph The graph to write.
+ * @return True if successfully written, false on any error.
+ */
+bool write_snapshot_file(const std::filesystem::path& path, const Graph& graph);
+
+/**
+ * @brief Reads a graph from a native snapshot file.
+ * @note Decodes straight out of a read only mapping of the file, without copying it first.
+ *
+ * @param path The path to read from.
+ * @return The graph, or null on any error.
+ */
+std::shared_ptr<const Graph> read_snapshot_file(const std::filesystem::path& path);
+
+}  // namespace live_object_explorer::refs::internal
+
+#endif /* REFS_SNAPSHOT_FILE_H */
@@ -5,39 +5,58 @@ using namespace unrealsdk::unreal;
 
 namespace live_object_explorer::refs::internal {
 
+/**
+ * @brief A small fixed size list of the refs held in an object's native fields.
+ * @note Called like a refs callback, so that each native field is just a single line.
+ */
+class NativeRefs {
+   public:
+    void operator()(UObject* /*from_obj*/, UObject* to_obj) {
+        if (this->count < this->refs.size()) {
+            this->refs[this->count++] = to_obj;
+        }
+    }
+
+    [[nodiscard]] std::span<UObject* const> get(void) const {
+        return std::span{this->refs}.first(this->count);
+    }
+
+   private:
+    // Classes and attribute properties have the most native refs, at 7
+    static constexpr size_t MAX_REFS = 8;
+
+    std::array<UObject*, MAX_REFS> refs{};
+    size_t count = 0;
+};
+
 /**
  * @brief Finds any refs in native fields on the object.
  *
  * @tparam T The type of the object.
  * @param obj The object to search form.
- * @param callback A callback to call with any discovered refs.
+ * @param callback The list to add any discovered refs to.
  */
 template <typename T>
     requires std::is_base_of_v<UObject, T>
-void find_native_refs(T* obj, const refs_callback& callback);
+void find_native_refs(T* obj, NativeRefs& callback);
 
 /**
- * @brief Finds any refs in fields controlled by properties.
+ * @brief Appends slots for any refs in fields controlled by properties to a layout.
  *
  * @tparam T The type of the property.
  * @param prop The property to look for references in.
- * @param idx The fixed array index to get the value at.
- * @param base_addr The base address of the object to read the property from.
- * @param obj The base object the search started from.
- * @param callback A callback to call with any discovered refs.
+ * @param offset The offset of the field (including fixed array index) from the layout's base.
+ * @param layouts The layout cache, used to look up any nested structs.
+ * @param layout The layout to append to.
  */
 template <typename T>
     requires std::is_base_of_v<ZProperty, T>
-void find_property_refs(T* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback);
+void append_property_slots(T* prop, uint32_t offset, RefLayoutCache& layouts, RefLayout& layout);
 
 // =================================================================================================
 
 template <>
-void find_native_refs(UObject* obj, const refs_callback& callback) {
+void find_native_refs(UObject* obj, NativeRefs& callback) {
     callback(obj, obj->Class());
     callback(obj, obj->Outer());
 }
@@ -45,7 +64,7 @@ void find_native_refs(UObject* obj, const refs_callback& callback) {
 // ======== First Layer Subclasses ========
 
 template <>
-void find_native_refs(UField* obj, const refs_callback& callback) {
+void find_native_refs(UField* obj, NativeRefs& callback) {
     callback(obj, obj->Next());
     find_native_refs<UObject>(obj, callback);
 }
@@ -53,26 +72,26 @@ void find_native_refs(UField* obj, const refs_callback& callback) {
 // ======== Second Layer Subclasses ========
 
 template <>
-void find_native_refs(UConst* obj, const refs_callback& callback) {
+void find_native_refs(UConst* obj, NativeRefs& callback) {
     find_native_refs<UField>(obj, callback);
 }
 
 template <>
-void find_native_refs(UEnum* obj, const refs_callback& callback) {
+void find_native_refs(UEnum* obj, NativeRefs& callback) {
     find_native_refs<UField>(obj, callback);
 }
 
 // We can only hold UObject refs, so if properties are fields we need to exclude them here
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZProperty* obj, NativeRefs& callback) {
     callback(obj, obj->PropertyLinkNext());
     find_native_refs<UField>(obj, callback);
 }
 #endif
 
 template <>
-void find_native_refs(UStruct* obj, const refs_callback& callback) {
+void find_native_refs(UStruct* obj, NativeRefs& callback) {
     callback(obj, obj->SuperField());
     callback(obj, obj->Children());
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
@@ -85,149 +104,149 @@ void find_native_refs(UStruct* obj, const refs_callback& callback) {
 
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZArrayProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZArrayProperty* obj, NativeRefs& callback) {
     callback(obj, obj->Inner());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZBoolProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZBoolProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZByteProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZByteProperty* obj, NativeRefs& callback) {
     callback(obj, obj->Enum());
     find_native_refs<ZProperty>(obj, callback);
 }
 #endif
 
 template <>
-void find_native_refs(UClass* obj, const refs_callback& callback) {
+void find_native_refs(UClass* obj, NativeRefs& callback) {
     callback(obj, obj->ClassDefaultObject());
     find_native_refs<UStruct>(obj, callback);
 }
 
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZDelegateProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZDelegateProperty* obj, NativeRefs& callback) {
     callback(obj, obj->Signature());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZDoubleProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZDoubleProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZEnumProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZEnumProperty* obj, NativeRefs& callback) {
     callback(obj, obj->UnderlyingProp());
     callback(obj, obj->Enum());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZFloatProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZFloatProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 #endif
 
 template <>
-void find_native_refs(UFunction* obj, const refs_callback& callback) {
+void find_native_refs(UFunction* obj, NativeRefs& callback) {
     find_native_refs<UStruct>(obj, callback);
 }
 
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZGameDataHandleProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZGameDataHandleProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZGbxDefPtrProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZGbxDefPtrProperty* obj, NativeRefs& callback) {
     callback(obj, obj->Struct());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZInt8Property* obj, const refs_callback& callback) {
+void find_native_refs(ZInt8Property* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZInt16Property* obj, const refs_callback& callback) {
+void find_native_refs(ZInt16Property* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZInt64Property* obj, const refs_callback& callback) {
+void find_native_refs(ZInt64Property* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZInterfaceProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZInterfaceProperty* obj, NativeRefs& callback) {
     callback(obj, obj->InterfaceClass());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZIntProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZIntProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZMulticastDelegateProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZMulticastDelegateProperty* obj, NativeRefs& callback) {
     callback(obj, obj->Signature());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZNameProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZNameProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZObjectProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZObjectProperty* obj, NativeRefs& callback) {
     callback(obj, obj->PropertyClass());
     find_native_refs<ZProperty>(obj, callback);
 }
 #endif
 
 template <>
-void find_native_refs(UScriptStruct* obj, const refs_callback& callback) {
+void find_native_refs(UScriptStruct* obj, NativeRefs& callback) {
     find_native_refs<UStruct>(obj, callback);
 }
 
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZStrProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZStrProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZStructProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZStructProperty* obj, NativeRefs& callback) {
     callback(obj, obj->Struct());
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZTextProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZTextProperty* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZUInt16Property* obj, const refs_callback& callback) {
+void find_native_refs(ZUInt16Property* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZUInt32Property* obj, const refs_callback& callback) {
+void find_native_refs(ZUInt32Property* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZUInt64Property* obj, const refs_callback& callback) {
+void find_native_refs(ZUInt64Property* obj, NativeRefs& callback) {
     find_native_refs<ZProperty>(obj, callback);
 }
 #endif
@@ -235,61 +254,61 @@ void find_native_refs(ZUInt64Property* obj, const refs_callback& callback) {
 // ======== Fourth Layer Subclasses ========
 
 template <>
-void find_native_refs(UBlueprintGeneratedClass* obj, const refs_callback& callback) {
+void find_native_refs(UBlueprintGeneratedClass* obj, NativeRefs& callback) {
     find_native_refs<UClass>(obj, callback);
 }
 
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZByteAttributeProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZByteAttributeProperty* obj, NativeRefs& callback) {
     callback(obj, obj->ModifierStackProperty());
     callback(obj, obj->OtherAttributeProperty());
     find_native_refs<ZByteProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZClassProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZClassProperty* obj, NativeRefs& callback) {
     callback(obj, obj->MetaClass());
     find_native_refs<ZObjectProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZComponentProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZComponentProperty* obj, NativeRefs& callback) {
     find_native_refs<ZObjectProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZFloatAttributeProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZFloatAttributeProperty* obj, NativeRefs& callback) {
     callback(obj, obj->ModifierStackProperty());
     callback(obj, obj->OtherAttributeProperty());
     find_native_refs<ZFloatProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZGbxInlineStructProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZGbxInlineStructProperty* obj, NativeRefs& callback) {
     callback(obj, obj->MetaStruct());
     find_native_refs<ZStructProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZIntAttributeProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZIntAttributeProperty* obj, NativeRefs& callback) {
     callback(obj, obj->ModifierStackProperty());
     callback(obj, obj->OtherAttributeProperty());
     find_native_refs<ZIntProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZLazyObjectProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZLazyObjectProperty* obj, NativeRefs& callback) {
     find_native_refs<ZObjectProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZSoftObjectProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZSoftObjectProperty* obj, NativeRefs& callback) {
     find_native_refs<ZObjectProperty>(obj, callback);
 }
 
 template <>
-void find_native_refs(ZWeakObjectProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZWeakObjectProperty* obj, NativeRefs& callback) {
     find_native_refs<ZObjectProperty>(obj, callback);
 }
 #endif
@@ -298,7 +317,7 @@ void find_native_refs(ZWeakObjectProperty* obj, const refs_callback& callback) {
 
 #if !UNREALSDK_PROPERTIES_ARE_FFIELD
 template <>
-void find_native_refs(ZSoftClassProperty* obj, const refs_callback& callback) {
+void find_native_refs(ZSoftClassProperty* obj, NativeRefs& callback) {
     find_native_refs<ZSoftObjectProperty>(obj, callback);
 }
 #endif
@@ -306,261 +325,226 @@ void find_native_refs(ZSoftClassProperty* obj, const refs_callback& callback) {
 // =================================================================================================
 // NOLINTBEGIN(readability-named-parameter)
 
+namespace {
+
+/**
+ * @brief Helper to append a slot which doesn't need any extra info.
+ *
+ * @param kind The kind of slot.
+ * @param offset The offset of the slot.
+ * @param layout The layout to append to.
+ */
+void append_simple_slot(RefSlot::Kind kind, uint32_t offset, RefLayout& layout) {
+    layout.slots.push_back(
+        {.offset = offset, .kind = kind, .element_size = 0, .element_layout = nullptr});
+}
+
+}  // namespace
+
 // ======== Third Layer Subclasses ========
 
 template <>
-void find_property_refs(ZArrayProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    auto arr = get_property(prop, idx, base_addr).base.get();
-    cast(
-        prop->Inner(),
-        [arr, obj, &callback]<typename T>(T* inner) {
-            auto element_size = inner->ElementSize();
-            for (size_t i = 0; i < arr->size(); i++) {
-                find_property_refs<T>(inner, 0,
-                                      reinterpret_cast<uintptr_t>(arr->data) + (element_size * i),
-                                      obj, callback);
-            }
-        },
-        // Fallback: ignore this property, assume no refs
-        [](ZProperty* /*prop*/) {});
+void append_property_slots(ZArrayProperty* prop,
+                           uint32_t offset,
+                           RefLayoutCache& layouts,
+                           RefLayout& layout) {
+    auto element_size = static_cast<uint32_t>(prop->Inner()->ElementSize());
+    layout.arrays.push_back({.offset = offset, .element_size = element_size});
+
+    const auto& element_layout = layouts.get_element(prop);
+    if (!layouts.may_have_refs(element_layout)) {
+        return;
+    }
+    layout.slots.push_back({.offset = offset,
+                            .kind = RefSlot::Kind::ARRAY,
+                            .element_size = element_size,
+                            .element_layout = &element_layout});
 }
 
 template <>
-void find_property_refs(ZBoolProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZBoolProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZByteProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZByteProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZDelegateProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    try {
-        auto delegate = get_property(prop, idx, base_addr);
-        if (delegate.has_value()) {
-            callback(obj, delegate->object);
-            callback(obj, delegate->func);
-        }
-    } catch (...) {}
+void append_property_slots(ZDelegateProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::DELEGATE, offset, layout);
 }
 
 template <>
-void find_property_refs(ZDoubleProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZDoubleProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZEnumProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZEnumProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZFloatProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZFloatProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZGameDataHandleProperty*,
-                        size_t,
-                        uintptr_t,
-                        UObject*,
-                        const refs_callback&) {
+void append_property_slots(ZGameDataHandleProperty*, uint32_t, RefLayoutCache&, RefLayout&) {
     // TODO: OAK2
 }
 
 template <>
-void find_property_refs(ZGbxDefPtrProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {
+void append_property_slots(ZGbxDefPtrProperty*, uint32_t, RefLayoutCache&, RefLayout&) {
     // TODO: OAK2
 }
 
 template <>
-void find_property_refs(ZInt8Property*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZInt8Property*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZInt16Property*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZInt16Property*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZInt64Property*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZInt64Property*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZInterfaceProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZInterfaceProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    // The object pointer is the first field of a script interface
+    append_simple_slot(RefSlot::Kind::OBJECT, offset, layout);
 }
 
 template <>
-void find_property_refs(ZIntProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZIntProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZMulticastDelegateProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    auto delegate = get_property(prop, idx, base_addr);
-    for (size_t i = 0; i < delegate.base->size(); i++) {
-        auto bound_obj = delegate.base->data[i].get_object();
-        if (bound_obj == nullptr) {
-            continue;
-        }
-        callback(obj, bound_obj);
-
-        UObject* func = nullptr;
-        try {
-            // The game can create invalid delegates sometimes, meaning this find call can fail
-            static_assert(!std::is_base_of_v<FField, UFunction>);
-            func = bound_obj->Class()->find(delegate.base->data[i].func_name).as_uobject();
-        } catch (...) {
-            continue;
-        }
-        callback(obj, func);
-    }
+void append_property_slots(ZMulticastDelegateProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::MULTICAST_DELEGATE, offset, layout);
 }
 
 template <>
-void find_property_refs(ZNameProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZNameProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZObjectProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZObjectProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::OBJECT, offset, layout);
 }
 
 template <>
-void find_property_refs(ZStrProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZStrProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZStructProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    auto value = get_property(prop, idx, base_addr);
-    auto new_base = reinterpret_cast<uintptr_t>(value.base.get());
-
-    for (auto inner_prop : value.type->properties()) {
-        cast(
-            inner_prop,
-            [new_base, obj, &callback]<typename T>(T* prop) {
-                for (size_t i = 0; i < static_cast<size_t>(prop->ArrayDim()); i++) {
-                    find_property_refs(prop, i, new_base, obj, callback);
-                }
-            },
-            // Fallback: ignore this property, assume no refs
-            [](ZProperty* /*prop*/) {});
+void append_property_slots(ZStructProperty* prop,
+                           uint32_t offset,
+                           RefLayoutCache& layouts,
+                           RefLayout& layout) {
+    // Inline the struct's slots into our own
+    const auto& struct_layout = layouts.get(prop->Struct());
+    for (const auto& slot : struct_layout.slots) {
+        layout.slots.push_back(slot);
+        layout.slots.back().offset += offset;
+    }
+    for (const auto& array : struct_layout.arrays) {
+        layout.arrays.push_back(array);
+        layout.arrays.back().offset += offset;
     }
 }
 
 template <>
-void find_property_refs(ZTextProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZTextProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZUInt16Property*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZUInt16Property*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZUInt32Property*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZUInt32Property*, uint32_t, RefLayoutCache&, RefLayout&) {}
 template <>
-void find_property_refs(ZUInt64Property*, size_t, uintptr_t, UObject*, const refs_callback&) {}
+void append_property_slots(ZUInt64Property*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 // ======== Fourth Layer Subclasses ========
 
 template <>
-void find_property_refs(ZByteAttributeProperty*,
-                        size_t,
-                        uintptr_t,
-                        UObject*,
-                        const refs_callback&) {}
+void append_property_slots(ZByteAttributeProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZClassProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZClassProperty*, uint32_t offset, RefLayoutCache&, RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::OBJECT, offset, layout);
 }
 
 template <>
-void find_property_refs(ZComponentProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZComponentProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::OBJECT, offset, layout);
 }
 
 template <>
-void find_property_refs(ZFloatAttributeProperty*,
-                        size_t,
-                        uintptr_t,
-                        UObject*,
-                        const refs_callback&) {}
+void append_property_slots(ZFloatAttributeProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZGbxInlineStructProperty*,
-                        size_t,
-                        uintptr_t,
-                        UObject*,
-                        const refs_callback&) {
+void append_property_slots(ZGbxInlineStructProperty*, uint32_t, RefLayoutCache&, RefLayout&) {
     // TODO OAK2
 }
 
 template <>
-void find_property_refs(ZIntAttributeProperty*, size_t, uintptr_t, UObject*, const refs_callback&) {
-}
+void append_property_slots(ZIntAttributeProperty*, uint32_t, RefLayoutCache&, RefLayout&) {}
 
 template <>
-void find_property_refs(ZLazyObjectProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZLazyObjectProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::LAZY_OBJECT, offset, layout);
 }
 
 template <>
-void find_property_refs(ZSoftObjectProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZSoftObjectProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::SOFT_OBJECT, offset, layout);
 }
 
 template <>
-void find_property_refs(ZWeakObjectProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZWeakObjectProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::WEAK_OBJECT, offset, layout);
 }
 
 // ======== Fifth Layer Subclasses ========
 
 template <>
-void find_property_refs(ZSoftClassProperty* prop,
-                        size_t idx,
-                        uintptr_t base_addr,
-                        UObject* obj,
-                        const refs_callback& callback) {
-    callback(obj, get_property(prop, idx, base_addr));
+void append_property_slots(ZSoftClassProperty*,
+                           uint32_t offset,
+                           RefLayoutCache&,
+                           RefLayout& layout) {
+    append_simple_slot(RefSlot::Kind::SOFT_OBJECT, offset, layout);
 }
 
 // NOLINTEND(readability-named-parameter)
 // =================================================================================================
 
-void search_for_refs(UObject* from_obj, const refs_callback& callback) {
-    cast<cast_options<true, true>>(
-        from_obj, [&callback]<typename T>(T* obj) { find_native_refs<T>(obj, callback); });
-
-    auto base_addr = reinterpret_cast<uintptr_t>(from_obj);
-    for (auto prop : from_obj->Class()->properties()) {
+/**
+ * @brief Appends slots for all properties on a struct to a layout.
+ *
+ * @param type The struct to append the properties of.
+ * @param base_offset The offset of the struct from the layout's base.
+ * @param layouts The layout cache, used to look up any nested structs.
+ * @param layout The layout to append to.
+ */
+void append_struct_slots(UStruct* type,
+                         uint32_t base_offset,
+                         RefLayoutCache& layouts,
+                         RefLayout& layout) {
+    for (auto prop : type->properties()) {
         cast<cast_options<false, true>>(
             prop,
-            [base_addr, from_obj, &callback]<typename T>(T* prop) {
+            [base_offset, &layouts, &layout]<typename T>(T* prop) {
                 auto array_dim = static_cast<size_t>(prop->ArrayDim());
                 for (size_t i = 0; i < array_dim; i++) {
-                    find_property_refs<T>(prop, i, base_addr, from_obj, callback);
+                    auto offset = base_offset + prop->Offset_Internal() + (prop->ElementSize() * i);
+                    append_property_slots<T>(prop, static_cast<uint32_t>(offset), layouts, layout);
+                    layout.slot_props.resize(layout.slots.size(), prop);
                 }
             },
             // Fallback: ignore this property, assume no refs
@@ -568,4 +552,368 @@ void search_for_refs(UObject* from_obj, const refs_callback& callback) {
     }
 }
 
+const RefLayout& RefLayoutCache::get(UStruct* type) {
+    if (type == this->last_type) {
+        return *this->last_layout;
+    }
+
+    auto [iter, inserted] = this->layouts.try_emplace(type);
+    auto& layout = iter->second;
+    if (inserted) {
+        // Compile straight into the cache, so if the struct contains an array of itself, the
+        // array's element layout links back to here
+        this->compiling.push_back(&layout);
+        append_struct_slots(type, 0, *this, layout);
+        this->compiling.pop_back();
+        layout.slots.shrink_to_fit();
+        layout.slot_props.shrink_to_fit();
+        layout.arrays.shrink_to_fit();
+    }
+
+    this->last_type = type;
+    this->last_layout = &layout;
+    return layout;
+}
+
+const RefLayout& RefLayoutCache::get_element(ZArrayProperty* prop) {
+    auto inner = prop->Inner();
+
+    // Arrays of structs can share the struct's layout directly
+    const RefLayout* struct_layout = nullptr;
+    if (inner->Offset_Internal() == 0) {
+        cast<cast_options<false, true>>(
+            inner,
+            [this, &struct_layout]<typename T>(T* inner) {
+                if constexpr (std::is_same_v<T, ZStructProperty>) {
+                    struct_layout = &this->get(inner->Struct());
+                }
+            },
+            [](ZProperty* /*inner*/) {});
+    }
+    if (struct_layout != nullptr) {
+        return *struct_layout;
+    }
+
+    auto [iter, inserted] = this->element_layouts.try_emplace(prop);
+    auto& layout = iter->second;
+    if (inserted) {
+        cast<cast_options<false, true>>(
+            inner,
+            [this, &layout]<typename T>(T* inner) {
+                append_property_slots<T>(inner, static_cast<uint32_t>(inner->Offset_Internal()),
+                                         *this, layout);
+                layout.slot_props.resize(layout.slots.size(), inner);
+            },
+            // Fallback: ignore this property, assume no refs
+            [](ZProperty* /*inner*/) {});
+    }
+    return layout;
+}
+
+bool RefLayoutCache::may_have_refs(const RefLayout& layout) const {
+    // If a layout's still being compiled, we can't tell yet
+    return !layout.slots.empty()
+           || std::ranges::find(this->compiling, &layout) != this->compiling.end();
+}
+
+UObject* RefLayoutCache::get_function(UClass* cls, const FName& func_name) {
+    auto [iter, inserted] = this->functions.try_emplace(FunctionKey::make(cls, func_name), nullptr);
+    if (inserted) {
+        // Functions are always UObjects, if we found anything else it's not what we're after
+        static_assert(!std::is_base_of_v<FField, UFunction>);
+        auto func = find_delegate_function(cls, func_name);
+        if (func != nullptr && !func.is_ffield()) {
+            iter->second = func.as_uobject();
+        }
+    }
+    return iter->second;
+}
+
+// =================================================================================================
+
+namespace {
+
+/**
+ * @brief A sink which ignores all refs, for when we only want the hash.
+ */
+struct NullSink {
+    void operator()(UObject* /*from_obj*/, UObject* /*to_obj*/) {}
+};
+
+/**
+ * @brief Mixes a value into a hash.
+ *
+ * @param hash The hash to update.
+ * @param value The value to mix in.
+ */
+void mix_hash(uint64_t& hash, uint64_t value) {
+    const constexpr uint64_t multiplier = 0x9E3779B97F4A7C15;
+    const constexpr auto rotation = 23;
+    hash = (std::rotl(hash, rotation) ^ value) * multiplier;
+}
+
+/**
+ * @brief Mixes a block of raw memory into a hash.
+ *
+ * @param hash The hash to update.
+ * @param addr The address of the memory.
+ * @param size The size of the memory.
+ */
+void mix_hash_bytes(uint64_t& hash, uintptr_t addr, size_t size) {
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+        uint64_t value = 0;
+        memcpy(&value, reinterpret_cast<void*>(addr + i), std::min(sizeof(value), size - i));
+        mix_hash(hash, value);
+    }
+}
+
+/**
+ * @brief Finds the refs held by a single delegate.
+ * @note Hashes the delegate's function name rather than the function it resolves to, so hashing on
+ *       it's own never needs to look functions up.
+ *
+ * @tparam Hash If to mix the delegate into the hash.
+ * @tparam Sink The type of the sink. If `NullSink`, the function isn't looked up at all.
+ * @param delegate The delegate to search.
+ * @param obj The base object the search started from.
+ * @param layouts The layout cache to use.
+ * @param callback The sink to pass any discovered refs to.
+ * @param hash The hash to update.
+ */
+template <bool Hash, typename Sink>
+void find_delegate_refs(const FScriptDelegate& delegate,
+                        UObject* obj,
+                        RefLayoutCache& layouts,
+                        Sink& callback,
+                        uint64_t& hash) {
+    auto bound_obj = delegate.get_object();
+    if constexpr (Hash) {
+        mix_hash(hash, reinterpret_cast<uintptr_t>(bound_obj));
+        mix_hash_bytes(hash, reinterpret_cast<uintptr_t>(&delegate.func_name), sizeof(FName));
+    }
+    if constexpr (!std::is_same_v<Sink, NullSink>) {
+        if (bound_obj == nullptr) {
+            return;
+        }
+        callback(obj, bound_obj);
+
+        auto func = layouts.get_function(bound_obj->Class(), delegate.func_name);
+        if (func != nullptr) {
+            callback(obj, func);
+        }
+    }
+}
+
+/**
+ * @brief Finds all refs held in the slots of a layout.
+ * @note This is the only definition of what an object's refs hash covers, so hashing while
+ *       searching gives exactly the same hash as hashing on it's own.
+ *
+ * @tparam Hash If to mix everything we read into the hash.
+ * @tparam Sink The type of the sink.
+ * @param layout The layout to search through.
+ * @param base_addr The address to read the layout relative to.
+ * @param obj The base object the search started from.
+ * @param layouts The layout cache to use.
+ * @param callback The sink to pass any discovered refs to.
+ * @param hash The hash to update.
+ */
+template <bool Hash, typename Sink>
+void find_layout_refs(const RefLayout& layout,
+                      uintptr_t base_addr,
+                      UObject* obj,
+                      RefLayoutCache& layouts,
+                      Sink& callback,
+                      uint64_t& hash) {
+    // Weak pointers don't change when their target gets destroyed, so hash what they currently
+    // resolve to, same as we search
+    auto found_ref = [obj, &callback, &hash](UObject* to_obj) {
+        if constexpr (Hash) {
+            mix_hash(hash, reinterpret_cast<uintptr_t>(to_obj));
+        }
+        callback(obj, to_obj);
+    };
+
+    for (const auto& slot : layout.slots) {
+        auto addr = base_addr + slot.offset;
+        switch (slot.kind) {
+            case RefSlot::Kind::OBJECT:
+                found_ref(*reinterpret_cast<UObject**>(addr));
+                break;
+
+            case RefSlot::Kind::WEAK_OBJECT:
+                found_ref(
+                    unrealsdk::gobjects().get_weak_object(reinterpret_cast<FWeakObjectPtr*>(addr)));
+                break;
+
+            case RefSlot::Kind::LAZY_OBJECT:
+                found_ref(unrealsdk::gobjects().get_weak_object(
+                    &reinterpret_cast<FLazyObjectPtr*>(addr)->weak_ptr));
+                break;
+
+            case RefSlot::Kind::SOFT_OBJECT:
+                found_ref(unrealsdk::gobjects().get_weak_object(
+                    &reinterpret_cast<FSoftObjectPtr*>(addr)->weak_ptr));
+                break;
+
+            case RefSlot::Kind::DELEGATE:
+                find_delegate_refs<Hash>(*reinterpret_cast<FScriptDelegate*>(addr), obj, layouts,
+                                         callback, hash);
+                break;
+
+            case RefSlot::Kind::MULTICAST_DELEGATE: {
+                auto arr = reinterpret_cast<TArray<FScriptDelegate>*>(addr);
+                if constexpr (Hash) {
+                    mix_hash(hash, arr->size());
+                }
+                for (size_t i = 0; i < arr->size(); i++) {
+                    find_delegate_refs<Hash>(arr->data[i], obj, layouts, callback, hash);
+                }
+                break;
+            }
+
+            case RefSlot::Kind::ARRAY: {
+                auto arr = reinterpret_cast<TArray<uint8_t>*>(addr);
+                auto data = reinterpret_cast<uintptr_t>(arr->data);
+                if constexpr (Hash) {
+                    mix_hash(hash, arr->size());
+                }
+                for (size_t i = 0; i < arr->size(); i++) {
+                    find_layout_refs<Hash>(*slot.element_layout, data + (slot.element_size * i),
+                                           obj, layouts, callback, hash);
+                }
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gets all refs held in an object's native fields.
+ *
+ * @param obj The object to search.
+ * @return The list of native refs.
+ */
+NativeRefs get_native_refs(UObject* obj) {
+    NativeRefs native{};
+    cast<cast_options<true, true>>(
+        obj, [&native]<typename T>(T* obj) { find_native_refs<T>(obj, native); });
+    return native;
+}
+
+/**
+ * @brief Finds all refs held by an object, in both it's native fields and it's properties.
+ *
+ * @tparam Hash If to mix everything we read into the hash.
+ * @tparam Sink The type of the sink.
+ * @param from_obj The object to search from.
+ * @param layouts The layout cache to use.
+ * @param sink The sink to pass any discovered refs to.
+ * @param hash The hash to update.
+ */
+template <bool Hash, typename Sink>
+void find_object_refs(UObject* from_obj, RefLayoutCache& layouts, Sink& sink, uint64_t& hash) {
+    for (auto to_obj : get_native_refs(from_obj).get()) {
+        if constexpr (Hash) {
+            mix_hash(hash, reinterpret_cast<uintptr_t>(to_obj));
+        }
+        sink(from_obj, to_obj);
+    }
+
+    find_layout_refs<Hash>(layouts.get(from_obj->Class()), reinterpret_cast<uintptr_t>(from_obj),
+                           from_obj, layouts, sink, hash);
+}
+
+}  // namespace
+
+template <typename Sink>
+void search_for_refs(UObject* from_obj, RefLayoutCache& layouts, Sink& sink) {
+    uint64_t unused_hash = 0;
+    find_object_refs<false>(from_obj, layouts, sink, unused_hash);
+}
+
+template void search_for_refs<EdgeBuffer>(UObject* from_obj,
+                                          RefLayoutCache& layouts,
+                                          EdgeBuffer& sink);
+template void search_for_refs<const refs_callback>(UObject* from_obj,
+                                                   RefLayoutCache& layouts,
+                                                   const refs_callback& sink);
+
+uint64_t search_and_hash_refs(UObject* from_obj, RefLayoutCache& layouts, EdgeBuffer& sink) {
+    uint64_t hash = 0;
+    find_object_refs<true>(from_obj, layouts, sink, hash);
+    return hash;
+}
+
+uint64_t hash_refs(UObject* obj, RefLayoutCache& layouts) {
+    NullSink sink{};
+    uint64_t hash = 0;
+    find_object_refs<true>(obj, layouts, sink, hash);
+    return hash;
+}
+
+uint32_t shallow_size(UObject* obj, RefLayoutCache& layouts) {
+    auto cls = obj->Class();
+    auto size = static_cast<uint64_t>(std::max(cls->PropertySize(), 0));
+
+    auto base_addr = reinterpret_cast<uintptr_t>(obj);
+    for (const auto& array : layouts.get(cls).arrays) {
+        auto arr = reinterpret_cast<TArray<uint8_t>*>(base_addr + array.offset);
+        if (arr->data != nullptr && arr->max > 0) {
+            size += static_cast<uint64_t>(arr->max) * array.element_size;
+        }
+    }
+
+    return static_cast<uint32_t>(std::min<uint64_t>(size, std::numeric_limits<uint32_t>::max()));
+}
+
+std::string describe_ref(UObject* from_obj, UObject* to_obj, RefLayoutCache& layouts) {
+    if (from_obj->Class() == to_obj) {
+        return "Class";
+    }
+    if (from_obj->Outer() == to_obj) {
+        return "Outer";
+    }
+    auto native_refs = get_native_refs(from_obj);
+    if (std::ranges::find(native_refs.get(), to_obj) != native_refs.get().end()) {
+        return "(native field)";
+    }
+
+    bool found = false;
+    auto matcher = [to_obj, &found](UObject* /*from_obj*/, UObject* obj) {
+        found = found || obj == to_obj;
+    };
+    uint64_t unused_hash = 0;
+
+    // Search each slot individually, so we know which property it came from
+    const auto& layout = layouts.get(from_obj->Class());
+    auto base_addr = reinterpret_cast<uintptr_t>(from_obj);
+    for (size_t i = 0; i < layout.slots.size(); i++) {
+        const auto& slot = layout.slots[i];
+        const std::string prop_name{layout.slot_props[i]->Name()};
+
+        if (slot.kind != RefSlot::Kind::ARRAY) {
+            const RefLayout single_slot{.slots = {slot}, .arrays = {}, .slot_props = {}};
+            find_layout_refs<false>(single_slot, base_addr, from_obj, layouts, matcher,
+                                    unused_hash);
+            if (found) {
+                return prop_name;
+            }
+            continue;
+        }
+
+        auto arr = reinterpret_cast<TArray<uint8_t>*>(base_addr + slot.offset);
+        auto data = reinterpret_cast<uintptr_t>(arr->data);
+        for (size_t j = 0; j < arr->size(); j++) {
+            find_layout_refs<false>(*slot.element_layout, data + (slot.element_size * j),
+                                    from_obj, layouts, matcher, unused_hash);
+            if (found) {
+                return std::format("{}[{}]", prop_name, j);
+            }
+        }
+    }
+
+    return {};
+}
+
 }  // namespace live_object_explorer::refs::internal
@@ -2,19 +2,194 @@
 #define REFS_SEARCHER_H
 
 #include "pch.h"
+#include "function_cache.h"
 
 namespace live_object_explorer::refs::internal {
 
+// Type erased sink, for any callers which don't care about speed
 using refs_callback =
     std::function<void(unrealsdk::unreal::UObject* from_obj, unrealsdk::unreal::UObject* to_obj)>;
 
+/**
+ * @brief A sink which buffers up all non-null refs into a vector.
+ */
+struct EdgeBuffer {
+    std::vector<std::pair<uintptr_t, uintptr_t>> edges;
+
+    void operator()(unrealsdk::unreal::UObject* from_obj, unrealsdk::unreal::UObject* to_obj) {
+        if (to_obj == nullptr) {
+            return;
+        }
+        this->edges.emplace_back(reinterpret_cast<uintptr_t>(from_obj),
+                                 reinterpret_cast<uintptr_t>(to_obj));
+    }
+};
+
+struct RefLayout;
+
+/**
+ * @brief A single slot in a struct which may hold a reference.
+ */
+struct RefSlot {
+    enum class Kind : uint8_t {
+        OBJECT,
+        WEAK_OBJECT,
+        LAZY_OBJECT,
+        SOFT_OBJECT,
+        DELEGATE,
+        MULTICAST_DELEGATE,
+        ARRAY,
+    };
+
+    uint32_t offset;
+    Kind kind;
+
+    // Only used by arrays
+    uint32_t element_size;
+    const RefLayout* element_layout;
+};
+
+/**
+ * @brief The flattened list of all slots in a struct which may hold references.
+ * @note Nested structs and fixed arrays are inlined, so every slot is relative to the same base.
+ */
+struct RefLayout {
+    // An array in the struct, which owns a separately allocated buffer
+    struct ArrayBuffer {
+        uint32_t offset;
+        uint32_t element_size;
+    };
+
+    std::vector<RefSlot> slots;
+    // Every array in the struct, whether or not it may hold refs. Only used to work out how much
+    // memory an object owns.
+    std::vector<ArrayBuffer> arrays;
+    // The property each slot came from. Only used to describe refs after the fact, so kept out of
+    // the slots themselves to keep them small.
+    std::vector<unrealsdk::unreal::ZProperty*> slot_props;
+};
+
+/**
+ * @brief Caches the ref layout of each struct, so we only have to walk it's properties once.
+ * @note Also caches which function each delegate resolves to.
+ * @note Not thread safe, each thread should use their own cache.
+ * @note Only valid for a single snapshot, since structs may be unloaded later.
+ */
+class RefLayoutCache {
+   public:
+    /**
+     * @brief Gets the layout of the given struct, compiling it if required.
+     *
+     * @param type The struct to get the layout of.
+     * @return The struct's layout.
+     */
+    const RefLayout& get(unrealsdk::unreal::UStruct* type);
+
+    /**
+     * @brief Gets the layout of a single element of an array, compiling it if required.
+     *
+     * @param prop The array property to get the element layout of.
+     * @return The element layout.
+     */
+    const RefLayout& get_element(unrealsdk::unreal::ZArrayProperty* prop);
+
+    /**
+     * @brief Checks if a layout may contain any refs.
+     * @note Layouts which are still being compiled are assumed to.
+     *
+     * @param layout The layout to check.
+     * @return True if the layout may contain refs.
+     */
+    [[nodiscard]] bool may_have_refs(const RefLayout& layout) const;
+
+    /**
+     * @brief Gets the function a delegate bound to an object of the given class would call.
+     * @note Backed by the shared `find_delegate_function` cache, but keeps a local copy of each
+     *       result, so the common case doesn't need to touch the shared cache's lock.
+     *
+     * @param cls The class to look up the function on.
+     * @param func_name The name of the function.
+     * @return The function, or null if it couldn't be found.
+     */
+    unrealsdk::unreal::UObject* get_function(unrealsdk::unreal::UClass* cls,
+                                             const unrealsdk::unreal::FName& func_name);
+
+   private:
+    // Both of these are node-based, so layouts never move once inserted
+    std::unordered_map<unrealsdk::unreal::UStruct*, RefLayout> layouts;
+    std::unordered_map<unrealsdk::unreal::ZArrayProperty*, RefLayout> element_layouts;
+    std::unordered_map<FunctionKey, unrealsdk::unreal::UObject*, FunctionKeyHash> functions;
+
+    // The stack of layouts currently being compiled
+    std::vector<const RefLayout*> compiling;
+
+    // Most objects of the same class are allocated together, so keep a shortcut to the last one
+    unrealsdk::unreal::UStruct* last_type = nullptr;
+    const RefLayout* last_layout = nullptr;
+};
+
 /**
  * @brief Searches for spots where the given object references others.
+ * @note Generic over the sink so that it can be inlined into the search, this is called for every
+ *       single ref. Only instantiated for `EdgeBuffer` and `const refs_callback`.
+ *
+ * @tparam Sink The type of the sink. Called with the from and to objects of each ref.
+ * @param from_obj The object to search from.
+ * @param layouts The layout cache to use.
+ * @param sink The sink to pass any discovered refs to. May be passed null refs.
+ */
+template <typename Sink>
+void search_for_refs(unrealsdk::unreal::UObject* from_obj, RefLayoutCache& layouts, Sink& sink);
+
+/**
+ * @brief Hashes everything the given object may hold a reference through.
+ * @note If the hash hasn't changed since a previous snapshot, searching the object again would
+ *       find exactly the same refs, so it can be skipped. Cheaper than searching, since it never
+ *       has to resolve delegate functions.
+ *
+ * @param obj The object to hash.
+ * @param layouts The layout cache to use.
+ * @return The hash.
+ */
+uint64_t hash_refs(unrealsdk::unreal::UObject* obj, RefLayoutCache& layouts);
+
+/**
+ * @brief Searches for spots where the given object references others, hashing them as it goes.
+ * @note Reads each slot once, so this is much cheaper than calling both `search_for_refs` and
+ *       `hash_refs`.
  *
  * @param from_obj The object to search from.
- * @param callback A callback to call with any discovered refs.
+ * @param layouts The layout cache to use.
+ * @param sink The sink to pass any discovered refs to. May be passed null refs.
+ * @return The same hash `hash_refs` would return.
+ */
+uint64_t search_and_hash_refs(unrealsdk::unreal::UObject* from_obj,
+                              RefLayoutCache& layouts,
+                              EdgeBuffer& sink);
+
+/**
+ * @brief Works out how much memory an object owns directly.
+ * @note Only counts the object itself, and the buffers of any arrays directly in it (or in nested
+ *       structs), not the buffers of arrays inside array elements.
+ *
+ * @param obj The object to get the size of.
+ * @param layouts The layout cache to use.
+ * @return The object's shallow size, in bytes.
+ */
+uint32_t shallow_size(unrealsdk::unreal::UObject* obj, RefLayoutCache& layouts);
+
+/**
+ * @brief Works out which field of an object holds a reference to another.
+ * @note Much slower than searching, only meant for describing a handful of refs to the user.
+ *
+ * @param from_obj The object holding the reference.
+ * @param to_obj The referenced object.
+ * @param layouts The layout cache to use.
+ * @return The name of the field holding the reference, or an empty string if we couldn't find one.
  */
-void search_for_refs(unrealsdk::unreal::UObject* from_obj, const refs_callback& callback);
+std::string describe_ref(unrealsdk::unreal::UObject* from_obj,
+                         unrealsdk::unreal::UObject* to_obj,
+                         RefLayoutCache& layouts);
 
 }  // namespace live_object_explorer::refs::internal
 